@@ -0,0 +1,52 @@
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define AUTOTUNE_MAX_GEN_SIZE   255     // systematic index is one byte
+#define AUTOTUNE_DEFAULT_MAX_GEN_SIZE   64  // decoding cost grows with the square of it
+
+typedef enum
+{
+    AUTOTUNE_FULL_VECTOR = 0,   // coded packets carry the coefficient vector
+    AUTOTUNE_SEED_VECTOR = 1,   // coded packets carry a seed and density
+} autotune_vector_format_t;
+
+typedef struct
+{
+    uint32_t payload_size;      // bytes to transfer, 0 for an endless stream
+    uint8_t field_bits;         // 1, 4, 8, 16 or 32 (prime2325)
+    uint8_t vector_format;
+    uint16_t extra_header_size; // bytes in front of the packet besides IPHC/UDP, a mesh header
+    float loss;                 // packet loss rate
+    float target;               // decode probability per generation
+    uint16_t max_generation_size;
+} autotune_input_t;
+
+typedef struct
+{
+    uint16_t symbol_size;
+    uint16_t generation_size;
+    uint16_t tx_num;            // packets per generation
+    uint16_t redundancy;        // percent, rounded up
+    uint16_t packet_size;       // largest packet, at most MAX_MSDU_SIZE
+    uint32_t frame_num;         // frames to send the payload, per generation for a stream
+    float decode_probability;
+    float goodput;              // expected source bytes delivered per frame
+} autotune_result_t;
+
+/**
+ * @brief get the largest symbol that keeps a NC packet of the generation in one frame,
+ *        0 if the coding header alone does not fit
+ */
+uint16_t get_fitting_symbol_size (const autotune_input_t* input, uint16_t generation_size);
+
+/**
+ * @brief choose symbol size, generation size and redundancy that fill frames without
+ *        fragmentation and maximize goodput at the target decode probability,
+ *        return false if no configuration fits
+ */
+bool autotune_coding (const autotune_input_t* input, autotune_result_t* result);
+
+#endif /* AUTOTUNE_H */
@@ -0,0 +1,34 @@
+#ifndef CODING_VECTOR_H
+#define CODING_VECTOR_H
+
+#include <stdint.h>
+
+#define SEED_HDR_SIZE       3       // seed (2 bytes) + density (1 byte)
+#define SEED_DENSITY_SCALE  255
+
+/**
+ * @brief write seed and density of a seed encoded coding vector
+ */
+void set_seed_header (uint8_t* seed_offset, uint16_t seed, float density);
+
+/**
+ * @brief get seed of a seed encoded coding vector
+ */
+uint16_t get_seed (uint8_t* seed_offset);
+
+/**
+ * @brief get density of a seed encoded coding vector
+ */
+float get_seed_density (uint8_t* seed_offset);
+
+/**
+ * @brief expand a seed into a coding vector over the given field (nc_field_t)
+ *        with the given density
+ */
+void generate_seeded_coefficients (uint8_t* coefficients,
+                                   uint32_t symbols,
+                                   uint16_t seed,
+                                   float density,
+                                   uint8_t field);
+
+#endif /* CODING_VECTOR_H */
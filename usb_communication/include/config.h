@@ -1,8 +1,12 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
-#define CLIENT_ACK  "client_ack"
-#define RELAY_ACK   "relay_ack"
-#define SERVER_ACK  "server_ack"
+#include "control.h"
+
+#define CLIENT_ACK  CONTROL_CLIENT_ACK
+#define RELAY_ACK   CONTROL_RELAY_ACK
+#define SERVER_ACK  CONTROL_SERVER_ACK
+
+#define MAX_PIPELINE_SIZE   8       // generations in flight at once
 
 #endif /* CONFIG_H */
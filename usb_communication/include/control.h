@@ -0,0 +1,127 @@
+#ifndef CONTROL_H
+#define CONTROL_H
+
+/*
+   control frame structure, shared by host applications and dongle firmware
+   +-------+------+----------+----------------------+
+   | 0111  | type | sequence | optional (0-2 bytes) |
+   +-------+------+----------+----------------------+
+    4 bits 4 bits   1 byte
+   The dispatch 0x70-0x7f is above MAX_MSDU_SIZE, so it never collides with
+   the length byte of a normal packet or with a fragment/mesh dispatch.
+   The optional part size is fixed by the type.
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CONTROL_HDR_SIZE        2
+#define CONTROL_MAX_SIZE        4
+#define CONTROL_TYPE_NUM        16
+
+enum
+{
+    k_control_type_mask = 0x70,     // 0b0111_0000
+    k_control_dispatch_mask = 0xf0, // 0b1111_0000
+    k_control_subtype_mask = 0x0f,
+};
+
+typedef enum
+{
+    CONTROL_CLIENT_ACK = 0,
+    CONTROL_RELAY_ACK = 1,
+    CONTROL_SERVER_ACK = 2,
+    CONTROL_BITMAP_ACK = 3,     // 16-bit bitmap of received frames
+    CONTROL_WINDOW_ACK = 4,     // 16-bit sliding window edge
+    CONTROL_GENERATION_ACK = 5, // sequence carries the decoded generation
+    CONTROL_RANK_REPORT = 6,    // sequence carries the generation, rank and received packets
+} control_type_t;
+
+typedef struct
+{
+    uint8_t type;
+    uint8_t sequence;
+    uint16_t option;
+    uint8_t length;
+} control_frame_t;
+
+// optional part size of every control type
+static const uint8_t control_option_size[CONTROL_TYPE_NUM] = {0, 0, 0, 2, 2, 0, 2};
+
+/**
+ * @brief check if a frame is a control frame
+ */
+static inline bool is_control_frame (const uint8_t* frame)
+{
+    return (*frame & k_control_dispatch_mask) == k_control_type_mask;
+}
+
+/**
+ * @brief get control frame length from its first byte
+ */
+static inline uint8_t get_control_frame_length (const uint8_t* frame)
+{
+    return CONTROL_HDR_SIZE + control_option_size[*frame & k_control_subtype_mask];
+}
+
+/**
+ * @brief build a control frame, return frame length
+ */
+static inline uint8_t build_control_frame (uint8_t* frame,
+                                           uint8_t type,
+                                           uint8_t sequence,
+                                           uint16_t option)
+{
+    type &= k_control_subtype_mask;
+    frame[0] = k_control_type_mask | type;
+    frame[1] = sequence;
+    // optional part is big endian
+    if (control_option_size[type] == 2)
+    {
+        frame[2] = (uint8_t)(option >> 8);
+        frame[3] = (uint8_t)option;
+    }
+    else if (control_option_size[type] == 1)
+        frame[2] = (uint8_t)option;
+    return CONTROL_HDR_SIZE + control_option_size[type];
+}
+
+/**
+ * @brief parse a control frame, return false if it is not a valid control frame
+ */
+static inline bool parse_control_frame (const uint8_t* frame,
+                                        uint16_t length,
+                                        control_frame_t* control)
+{
+    if (length < CONTROL_HDR_SIZE || is_control_frame (frame) == false)
+        return false;
+    control->type = frame[0] & k_control_subtype_mask;
+    control->length = CONTROL_HDR_SIZE + control_option_size[control->type];
+    if (length < control->length)
+        return false;
+    control->sequence = frame[1];
+    control->option = 0;
+    if (control_option_size[control->type] == 2)
+        control->option = ((uint16_t)frame[2] << 8) | frame[3];
+    else if (control_option_size[control->type] == 1)
+        control->option = frame[2];
+    return true;
+}
+
+/**
+ * @brief check if a frame acknowledges a frame sent towards the server
+ */
+static inline bool is_control_ack (const uint8_t* frame, uint16_t length)
+{
+    control_frame_t control;
+    if (parse_control_frame (frame, length, &control) == false)
+        return false;
+    return control.type == CONTROL_RELAY_ACK ||
+           control.type == CONTROL_SERVER_ACK ||
+           control.type == CONTROL_BITMAP_ACK ||
+           control.type == CONTROL_WINDOW_ACK ||
+           control.type == CONTROL_GENERATION_ACK ||
+           control.type == CONTROL_RANK_REPORT;
+}
+
+#endif /* CONTROL_H */
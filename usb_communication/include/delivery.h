@@ -0,0 +1,56 @@
+#ifndef DELIVERY_H
+#define DELIVERY_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief called for every source symbol delivered in order
+ */
+typedef void (*delivery_callback_t) (uint8_t generation_id,
+                                     uint16_t index,
+                                     const uint8_t* symbol,
+                                     uint16_t length,
+                                     void* context);
+
+typedef struct
+{
+    FILE* fp;                       // file or pipe the symbols are written to, NULL if none
+    delivery_callback_t callback;   // NULL if none
+    void* context;
+    uint8_t head_generation;        // generation streamed now, the others wait for their turn
+    uint32_t symbol_num;            // symbols delivered
+    uint64_t byte_num;              // bytes delivered
+} delivery_sink_t;
+
+/**
+ * @brief open a delivery sink on a file or named pipe, NULL opens no file
+ */
+int open_delivery_sink (delivery_sink_t* sink, const char* path);
+
+/**
+ * @brief set a callback that gets every delivered symbol
+ */
+void set_delivery_callback (delivery_sink_t* sink, delivery_callback_t callback, void* context);
+
+/**
+ * @brief check if a sink has a file or callback to deliver to
+ */
+bool is_delivery_sink_open (delivery_sink_t* sink);
+
+/**
+ * @brief hand one source symbol to the sink, return -1 on write failure
+ */
+int deliver_symbol (delivery_sink_t* sink,
+                    uint8_t generation_id,
+                    uint16_t index,
+                    const uint8_t* symbol,
+                    uint16_t length);
+
+/**
+ * @brief flush and close a delivery sink
+ */
+void close_delivery_sink (delivery_sink_t* sink);
+
+#endif /* DELIVERY_H */
@@ -0,0 +1,89 @@
+#ifndef FEC_H
+#define FEC_H
+
+#include <stdint.h>
+
+#include "lowpan.h"
+
+#define FEC_FRAG_HDR_SIZE       7       // FEC fragment header size in octets.
+#define FEC_FRAG_DATA_SIZE      OTHER_FRAG_DATA_SIZE
+#define FEC_FRAG_DATA_OFFSET    FEC_FRAG_HDR_SIZE
+#define FEC_MAX_DATA_FRAG_NUM   ((MAX_PACKET_SIZE + FEC_FRAG_DATA_SIZE - 1) / FEC_FRAG_DATA_SIZE)
+#define FEC_MAX_PARITY_NUM      8
+#define FEC_MAX_FRAG_NUM        (FEC_MAX_DATA_FRAG_NUM + FEC_MAX_PARITY_NUM)
+
+enum
+{
+    k_fec_frag_type_mask = 0xd0,    // 0b1101_0000
+    k_fec_frag_dispatch_mask = 0xf8,
+};
+
+typedef struct
+{
+    uint8_t fragments[FEC_MAX_FRAG_NUM][FEC_FRAG_DATA_SIZE];
+    uint8_t rows[FEC_MAX_DATA_FRAG_NUM];
+    bool received[FEC_MAX_FRAG_NUM];
+    uint16_t datagram_tag;
+    uint16_t datagram_size;
+    uint8_t fragment_size;
+    uint8_t data_num;
+    uint8_t parity_num;
+    uint8_t received_num;
+    bool complete;
+    bool idle;
+} fec_reassembler_t;
+
+/**
+ * @brief check if a frame is a FEC fragment
+ */
+bool is_fec_fragment (uint8_t* frame);
+
+/**
+ * @brief calculate number of data fragments for a datagram
+ */
+uint8_t calculate_fec_data_num (uint16_t datagram_size);
+
+/**
+ * @brief calculate payload size of every fragment for a datagram
+ */
+uint8_t calculate_fec_fragment_size (uint16_t datagram_size);
+
+/**
+ * @brief calculate length of a FEC fragment from its header
+ */
+uint8_t calculate_fec_frame_length (uint8_t* frame);
+
+/**
+ * @brief fragment a datagram into k data and r parity fragments, return k + r
+ */
+uint8_t do_fec_fragmentation (virtual_packet_t tx_packet[],
+                              uint8_t* payload,
+                              uint16_t length,
+                              uint8_t parity_num);
+
+/**
+ * @brief initialize FEC reassembler
+ */
+void init_fec_reassembler (void);
+
+/**
+ * @brief check if FEC reassembler is running
+ */
+bool is_fec_reassembler_running (void);
+
+/**
+ * @brief feed a FEC fragment into the reassembler, return false if it is not accepted
+ */
+bool read_fec_fragment (uint8_t* frame, uint16_t length);
+
+/**
+ * @brief check if a datagram is rebuilt from the received fragments
+ */
+bool is_fec_reassemble_complete (void);
+
+/**
+ * @brief extract a rebuilt datagram to another buffer, return datagram size
+ */
+uint16_t extract_fec_packet (uint8_t* extract_buffer);
+
+#endif /* FEC_H */
@@ -0,0 +1,45 @@
+#ifndef FILE_MAP_H
+#define FILE_MAP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct
+{
+    uint8_t* data;
+    uint64_t size;
+    bool mapped;    // mmap'd file, otherwise a heap buffer read from stdin
+} file_map_t;
+
+/**
+ * @brief map an input file read only, "-" reads stdin into memory, return -1 on failure
+ */
+int map_input_file (file_map_t* map, const char* path);
+
+/**
+ * @brief create or truncate an output file of the given size and map it writable,
+ *        return -1 on failure
+ */
+int map_output_file (file_map_t* map, const char* path, uint64_t size);
+
+/**
+ * @brief flush a writable mapping and release a file map
+ */
+void unmap_file (file_map_t* map);
+
+/**
+ * @brief get the number of blocks of block_length bytes a file is split into
+ */
+uint32_t get_file_block_num (file_map_t* map, uint32_t block_length);
+
+/**
+ * @brief get the bytes of a file in a block, the last block may be short
+ */
+uint32_t get_file_block_length (file_map_t* map, uint32_t block, uint32_t block_length);
+
+/**
+ * @brief get the bytes of a source symbol in a block, 0 past the end of a short block
+ */
+uint16_t get_block_symbol_length (uint32_t block_length, uint16_t index, uint16_t symbol_size);
+
+#endif /* FILE_MAP_H */
@@ -0,0 +1,43 @@
+#ifndef GF256_H
+#define GF256_H
+
+#include <stdint.h>
+
+#define GF256_POLYNOMIAL    0x11d   // x^8 + x^4 + x^3 + x^2 + 1
+
+/**
+ * @brief initialize log/exp tables of GF(2^8)
+ */
+void gf256_init (void);
+
+/**
+ * @brief multiply two field elements
+ */
+uint8_t gf256_mul (uint8_t a, uint8_t b);
+
+/**
+ * @brief divide two field elements, b must not be zero
+ */
+uint8_t gf256_div (uint8_t a, uint8_t b);
+
+/**
+ * @brief invert a field element, a must not be zero
+ */
+uint8_t gf256_inv (uint8_t a);
+
+/**
+ * @brief add a buffer into another buffer: x[i] += y[i]
+ */
+void gf256_add_region (uint8_t* x, const uint8_t* y, uint32_t size);
+
+/**
+ * @brief multiply a buffer with a constant: x[i] *= c
+ */
+void gf256_mul_region (uint8_t* x, uint8_t c, uint32_t size);
+
+/**
+ * @brief add a multiplied buffer into another buffer: x[i] += c * y[i]
+ */
+void gf256_mul_add_region (uint8_t* x, const uint8_t* y, uint8_t c, uint32_t size);
+
+#endif /* GF256_H */
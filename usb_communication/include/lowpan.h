@@ -8,6 +8,7 @@
 #define MAX_MSDU_SIZE           100
 #define IPHC_TOTAL_SIZE         3       // LOWPAN_IPHC(2 bytes) + DST_ADDR(1 byte)
 #define UDPHC_TOTAL_SIZE        7
+#define UDPHC_FLOW_OFFSET       2       // low byte of the source port, tells the flows of several sources apart
 #define FIRST_FRAG_DATA_SIZE    72
 #define OTHER_FRAG_DATA_SIZE    88
 #define MAX_FRAG_NUM            ((MAX_PACKET_SIZE-(FIRST_FRAG_DATA_SIZE))/ \
@@ -15,6 +16,10 @@
 #define FIRST_FRAG_DATA_OFFSET  FIRST_FRAG_HDR_SIZE
 #define OTHER_FRAG_DATA_OFFSET  OTHER_FRAG_HDR_SIZE
 
+#define MESH_HDR_SIZE           5       // Mesh header with short originator and final address.
+#define MESH_MAX_HOPS_LEFT      15
+#define MESH_BROADCAST_ADDRESS  0xffff
+
 #define MAC_MAX_RETRIES         3
 #define FORWARDER_QUEUE_LENGTH  10
 
@@ -28,6 +33,11 @@ enum
 {
     k_first_frag_type_mask = 0xc0,  // 0b1100_0000
     k_other_frag_type_mask = 0xe0,  // 0b1110_0000
+    k_mesh_type_mask = 0x80,        // 0b1000_0000
+    k_mesh_dispatch_mask = 0xc0,    // 0b1100_0000
+    k_mesh_short_originator = 0x20, // V bit
+    k_mesh_short_final = 0x10,      // F bit
+    k_mesh_hops_left_mask = 0x0f,
 };
 
 typedef struct
@@ -109,6 +119,16 @@ void set_udp_header (uint8_t* udphc_offset);
  */
 uint8_t* get_udp_header (uint8_t* packet);
 
+/**
+ * @brief set the flow id, carried in the low byte of the compressed UDP source port
+ */
+void set_udp_flow (uint8_t* udphc_offset, uint8_t flow);
+
+/**
+ * @brief get the flow id
+ */
+uint8_t get_udp_flow (uint8_t* udphc_offset);
+
 /**
  * @brief set UDP checksum
  */
@@ -132,12 +152,72 @@ uint8_t get_tail_size (void);
 /**
  * @brief generate an ack packet
  */
-uint8_t generate_ack_packet (uint8_t* packet, uint8_t* ack);
+uint8_t generate_ack_packet (uint8_t* packet, uint8_t ack, uint8_t sequence);
 
 /**
  * @brief check if a packet is ackonwledgement or not
  */
-bool is_ack_packet (uint8_t* packet);
+bool is_ack_packet (uint8_t* packet, uint16_t length);
+
+/******************************************
+ * lowpan mesh header function declarations
+ *****************************************/
+
+/**
+ * @brief check if a frame starts with a mesh header
+ */
+bool has_mesh_header (uint8_t* frame);
+
+/**
+ * @brief set mesh header with short originator and final destination address
+ */
+uint8_t set_mesh_header (uint8_t* mesh_offset,
+                         uint16_t originator,
+                         uint16_t final_destination,
+                         uint8_t hops_left);
+
+/**
+ * @brief get originator address in mesh header
+ */
+uint16_t get_mesh_originator (uint8_t* mesh_offset);
+
+/**
+ * @brief get final destination address in mesh header
+ */
+uint16_t get_mesh_final_destination (uint8_t* mesh_offset);
+
+/**
+ * @brief get hops left in mesh header
+ */
+uint8_t get_mesh_hops_left (uint8_t* mesh_offset);
+
+/**
+ * @brief decrement hops left in mesh header, return false if no hop is left
+ */
+bool decrement_mesh_hops_left (uint8_t* mesh_offset);
+
+/**
+ * @brief prepend a mesh header to a frame, return new frame length or 0
+ */
+uint16_t add_mesh_header (virtual_packet_t* tx_packet,
+                          uint16_t originator,
+                          uint16_t final_destination,
+                          uint8_t hops_left);
+
+/**
+ * @brief strip the mesh header from a frame, return new frame length
+ */
+uint16_t remove_mesh_header (uint8_t* frame, uint16_t length);
+
+/**
+ * @brief set own mesh address
+ */
+void set_mesh_address (uint16_t address);
+
+/**
+ * @brief check if a mesh frame is addressed to this node
+ */
+bool is_mesh_for_me (uint8_t* mesh_offset);
 
 
 /******************************************
@@ -0,0 +1,57 @@
+#ifndef NC_FIELD_H
+#define NC_FIELD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// same order as fifi::finite_field, so an id casts to the kodo field
+typedef enum
+{
+    NC_FIELD_BINARY = 0,        // GF(2)
+    NC_FIELD_BINARY4 = 1,       // GF(2^4)
+    NC_FIELD_BINARY8 = 2,       // GF(2^8)
+    NC_FIELD_BINARY16 = 3,      // GF(2^16)
+    NC_FIELD_PRIME2325 = 4,     // GF(2^32 - 5)
+    NC_FIELD_NUM = 5,
+} nc_field_t;
+
+#define NC_FIELD_DEFAULT    NC_FIELD_BINARY8
+
+/**
+ * @brief map a field name (binary, binary4, binary8, binary16, prime2325) to its id,
+ *        return false for an unknown name
+ */
+bool parse_field_name (const char* name, uint8_t* field);
+
+/**
+ * @brief get a printable field name
+ */
+const char* get_field_name (uint8_t field);
+
+/**
+ * @brief get the bits of a field element, prime2325 counts as 32
+ */
+uint8_t get_field_bits (uint8_t field);
+
+/**
+ * @brief get the bytes of a packed coding vector over the given symbols
+ */
+uint32_t get_field_vector_size (uint8_t field, uint32_t symbols);
+
+/**
+ * @brief write an element into a packed coding vector, laid out as kodo does:
+ *        sub-byte elements from the least significant bit, wider ones little endian
+ */
+void set_field_value (uint8_t* elements, uint8_t field, uint32_t index, uint32_t value);
+
+/**
+ * @brief read an element from a packed coding vector
+ */
+uint32_t get_field_value (const uint8_t* elements, uint8_t field, uint32_t index);
+
+/**
+ * @brief map a random number to a non-zero field element
+ */
+uint32_t get_nonzero_field_value (uint8_t field, uint32_t random);
+
+#endif /* NC_FIELD_H */
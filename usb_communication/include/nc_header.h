@@ -0,0 +1,68 @@
+#ifndef NC_HEADER_H
+#define NC_HEADER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define NC_HEADER_VERSION   2
+#define NC_HDR_SIZE         4       // version/type/flags + generation id + field/symbol length
+#define NC_INDEX_SIZE       1       // symbol index of a systematic packet
+
+enum
+{
+    k_nc_version_mask = 0xc0,       // 0b1100_0000
+    k_nc_type_mask = 0x30,          // 0b0011_0000
+    k_nc_flags_mask = 0x0f,
+    k_nc_field_mask = 0xe0,         // 0b1110_0000 of the first length byte
+    k_nc_length_mask = 0x1fff,
+};
+
+typedef enum
+{
+    NC_SYSTEMATIC = 0,  // symbol index + source symbol
+    NC_CODED = 1,       // full coding vector + coded symbol
+    NC_SEEDED = 2,      // seed encoded coding vector + coded symbol
+    NC_PAYLOAD = 3,     // payload of the kodo payload API, carries its own coding header
+} nc_packet_type_t;
+
+// flags, 4 bits
+#define NC_FLAG_RECODED     0x01    // produced by a relay instead of the source
+#define NC_FLAG_ROUND_END   0x02    // last packet of a rateless round, the receiver reports its rank
+
+typedef struct
+{
+    uint8_t type;
+    uint8_t flags;
+    uint8_t generation_id;
+    uint8_t field;              // nc_field_t of the coding vector
+    uint16_t length;            // symbol or payload bytes carried, may be less than symbol size for a tail symbol
+    uint8_t index;              // NC_SYSTEMATIC
+    uint16_t seed;              // NC_SEEDED
+    float density;              // NC_SEEDED
+    uint8_t* coefficients;      // NC_CODED
+    uint16_t coefficient_size;  // NC_CODED
+    uint8_t* symbol;
+} nc_header_t;
+
+/**
+ * @brief get the largest NC header in front of a symbol
+ */
+uint16_t get_nc_max_header_size (uint16_t coefficient_size);
+
+/**
+ * @brief serialize header and symbol into a NC packet, return packet length
+ */
+uint16_t write_nc_packet (uint8_t* nc_packet, nc_header_t* header);
+
+/**
+ * @brief parse a NC packet, return false if it is malformed
+ *        a short tail symbol is padded with zeros in place up to symbol size,
+ *        so the packet buffer must hold a full symbol; payloads are left as they are
+ */
+bool parse_nc_packet (uint8_t* nc_packet,
+                      uint16_t length,
+                      uint16_t coefficient_size,
+                      uint16_t symbol_size,
+                      nc_header_t* header);
+
+#endif /* NC_HEADER_H */
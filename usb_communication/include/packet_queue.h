@@ -0,0 +1,48 @@
+#ifndef PACKET_QUEUE_H
+#define PACKET_QUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "lowpan.h"
+
+#define PACKET_QUEUE_LENGTH     16      // power of two
+
+typedef struct
+{
+    uint8_t packets[PACKET_QUEUE_LENGTH][MAX_PACKET_SIZE];
+    uint16_t lengths[PACKET_QUEUE_LENGTH];
+    uint32_t head;          // next packet to pop, written by the consumer only
+    uint32_t tail;          // next slot to push, written by the producer only
+    uint32_t drop_count;    // packets pushed while the queue was full
+    bool closed;            // the producer will push no more
+} packet_queue_t;
+
+/**
+ * @brief initialize a single producer single consumer packet queue
+ */
+void init_packet_queue (packet_queue_t* queue);
+
+/**
+ * @brief copy a packet into the queue, return false and drop it if the queue is full
+ *        producer side only
+ */
+bool packet_queue_push (packet_queue_t* queue, const uint8_t* packet, uint16_t length);
+
+/**
+ * @brief copy the oldest packet out of the queue, return its length or 0 if the queue is empty
+ *        consumer side only
+ */
+uint16_t packet_queue_pop (packet_queue_t* queue, uint8_t* packet);
+
+/**
+ * @brief tell the consumer no more packets will be pushed
+ */
+void close_packet_queue (packet_queue_t* queue);
+
+/**
+ * @brief check if the queue is closed and every packet has been popped
+ */
+bool is_packet_queue_drained (packet_queue_t* queue);
+
+#endif /* PACKET_QUEUE_H */
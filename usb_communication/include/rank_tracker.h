@@ -0,0 +1,48 @@
+#ifndef RANK_TRACKER_H
+#define RANK_TRACKER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <kodo_rlnc/coders.hpp>
+
+typedef struct
+{
+    kodo_rlnc::decoder* decoder;    // one byte symbols, only the coding vectors are eliminated
+    uint8_t* storage;               // decoder symbol storage
+    uint8_t* coefficients;          // scratch copy, the decoder eliminates in place
+    uint32_t coefficient_size;
+    uint8_t symbol;                 // dummy symbol
+} rank_tracker_t;
+
+/**
+ * @brief create a tracker of the rank a relay holds of a generation
+ */
+void init_rank_tracker (rank_tracker_t* tracker, fifi::finite_field field, uint32_t generation_size);
+
+/**
+ * @brief forget the coding vectors of the previous generation
+ */
+void reset_rank_tracker (rank_tracker_t* tracker);
+
+/**
+ * @brief add a coding vector, return true if it raised the rank
+ */
+bool track_coded_symbol (rank_tracker_t* tracker, const uint8_t* coefficients);
+
+/**
+ * @brief add the unit vector of a systematic symbol, return true if it raised the rank
+ */
+bool track_systematic_symbol (rank_tracker_t* tracker, uint32_t index);
+
+/**
+ * @brief get the rank held
+ */
+uint32_t get_tracked_rank (rank_tracker_t* tracker);
+
+/**
+ * @brief release a tracker
+ */
+void free_rank_tracker (rank_tracker_t* tracker);
+
+#endif /* RANK_TRACKER_H */
@@ -35,6 +35,11 @@ uint8_t read_frame (uint8_t* frame, uint16_t length);
  */
 void start_new_reassemble (uint8_t* frame);
 
+/**
+ * @brief feed a fragment into the reassembler, return false if it is not accepted
+ */
+bool reassemble_fragment (uint8_t* frame, uint16_t length);
+
 /**
  * @brief calculate rx number order
  */
@@ -0,0 +1,76 @@
+#ifndef RECODER_CACHE_H
+#define RECODER_CACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <kodo_rlnc/coders.hpp>
+
+#include "rank_tracker.h"
+
+#define RECODER_CACHE_MAX_ENTRIES   64      // upper bound whatever the memory budget
+#define RECODER_CACHE_BUDGET        16      // KiB, default memory budget
+
+typedef struct
+{
+    kodo_rlnc::pure_recoder* recoder;
+    rank_tracker_t tracker;     // rank held of the generation in the recoder
+    uint8_t flow;
+    uint8_t generation_id;
+    bool used;                  // holds a generation
+    uint64_t last_use;          // cache clock at the last lookup, least recent is evicted first
+    uint16_t repair_budget;     // repair packets left for the generation
+    uint16_t repair_due;        // repair packets waiting for the pacer
+    uint64_t last_rx_time;      // us
+} recoder_entry_t;
+
+typedef struct
+{
+    recoder_entry_t* entries;
+    uint32_t capacity;          // entries the memory budget affords
+    uint32_t size;              // entries constructed so far
+    uint64_t clock;
+    uint8_t field_id;
+    uint32_t generation_size;
+    uint32_t symbol_size;
+    uint32_t recoder_symbols;
+    uint32_t hit_count;
+    uint32_t miss_count;
+    uint32_t eviction_count;
+} recoder_cache_t;
+
+/**
+ * @brief get the memory a recoder and its rank tracker hold in bytes
+ */
+uint32_t get_recoder_memory (uint8_t field_id,
+                             uint32_t generation_size,
+                             uint32_t symbol_size,
+                             uint32_t recoder_symbols);
+
+/**
+ * @brief create a cache of as many recoders as the memory budget affords,
+ *        the first recoder is constructed at once
+ */
+void init_recoder_cache (recoder_cache_t* cache,
+                         uint8_t field_id,
+                         uint32_t generation_size,
+                         uint32_t symbol_size,
+                         uint32_t recoder_symbols,
+                         uint32_t memory_budget);
+
+/**
+ * @brief get the recoder of a generation of a flow. A generation not held yet
+ *        gets a new recoder while the budget lasts, then the least recently used
+ *        one is reset and reused. fresh is set when the recoder starts empty
+ */
+recoder_entry_t* get_cached_recoder (recoder_cache_t* cache,
+                                     uint8_t flow,
+                                     uint8_t generation_id,
+                                     bool* fresh);
+
+/**
+ * @brief release every recoder of the cache
+ */
+void free_recoder_cache (recoder_cache_t* cache);
+
+#endif /* RECODER_CACHE_H */
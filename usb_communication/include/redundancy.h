@@ -0,0 +1,43 @@
+#ifndef REDUNDANCY_H
+#define REDUNDANCY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define LOSS_EWMA_ALPHA     0.25    // weight of the newest loss sample
+
+typedef struct
+{
+    float loss;     // smoothed packet loss rate
+    float alpha;
+} loss_estimator_t;
+
+/**
+ * @brief initialize a loss estimator, the initial loss acts as a prior for the first samples
+ */
+void init_loss_estimator (loss_estimator_t* estimator, float alpha, float initial_loss);
+
+/**
+ * @brief add a loss sample from the packets sent and received
+ */
+void update_loss_estimator (loss_estimator_t* estimator, uint16_t tx_num, uint16_t rx_num);
+
+/**
+ * @brief get the fewest transmissions for a generation to be decoded
+ *        with at least the target probability at the given loss rate
+ */
+uint16_t get_adaptive_tx_num (uint16_t generation_size,
+                              float loss,
+                              float target,
+                              uint16_t max_tx_num);
+
+/**
+ * @brief get the probability that a generation sent in tx_num random linear
+ *        combinations over GF(2^field_bits) is decoded at the given loss rate
+ */
+double get_decode_probability (uint16_t generation_size,
+                               uint16_t tx_num,
+                               float loss,
+                               uint8_t field_bits);
+
+#endif /* REDUNDANCY_H */
@@ -23,6 +23,8 @@ bool need_serial_fragmentation (int length);
 
 tx_buf_t* serial_fragmentation (uint8_t* data, int length);
 
+uint8_t calculate_frame_length (uint8_t* frame);
+
 uint16_t read_serial_port (int fd, uint8_t* extract_buf, uint16_t* rx_frame_count, bool frame_only);
 
 bool wait_ack (int fd, uint16_t ack_timeout);
@@ -0,0 +1,102 @@
+#ifndef SLIDING_WINDOW_H
+#define SLIDING_WINDOW_H
+
+#include <stdint.h>
+
+#include "lowpan.h"
+
+#define SW_MAX_WINDOW_SIZE      32      // Must be a power of two.
+#define SW_MAX_SYMBOL_SIZE      MAX_PACKET_SIZE
+#define SW_SYSTEMATIC_HDR_SIZE  3       // type + sequence
+#define SW_REPAIR_HDR_SIZE      4       // type + window start + window count
+
+enum
+{
+    k_sw_systematic_type = 0x00,
+    k_sw_repair_type = 0x01,
+};
+
+typedef struct
+{
+    uint8_t symbols[SW_MAX_WINDOW_SIZE][SW_MAX_SYMBOL_SIZE];
+    uint16_t window_start;  // oldest symbol not acknowledged by the receiver
+    uint16_t window_end;    // sequence of the next source symbol
+    uint8_t window_size;
+    uint16_t symbol_size;
+} sliding_encoder_t;
+
+typedef struct
+{
+    uint8_t coefficients[SW_MAX_WINDOW_SIZE];
+    uint8_t symbol[SW_MAX_SYMBOL_SIZE];
+    bool valid;
+} sliding_row_t;
+
+typedef struct
+{
+    sliding_row_t rows[SW_MAX_WINDOW_SIZE];             // reduced rows, indexed by pivot
+    uint8_t decoded[SW_MAX_WINDOW_SIZE][SW_MAX_SYMBOL_SIZE];
+    uint16_t decoded_seq[SW_MAX_WINDOW_SIZE];
+    bool decoded_valid[SW_MAX_WINDOW_SIZE];
+    uint16_t window_edge;   // next symbol to be decoded in order
+    uint16_t read_seq;      // next decoded symbol to be handed to the application
+    uint16_t symbol_size;
+    uint8_t rank;           // number of rows held for undecoded symbols
+} sliding_decoder_t;
+
+/**
+ * @brief initialize a sliding window encoder
+ */
+void init_sliding_encoder (sliding_encoder_t* encoder, uint8_t window_size, uint16_t symbol_size);
+
+/**
+ * @brief check if the encoder window can not take more source symbols
+ */
+bool is_sliding_window_full (sliding_encoder_t* encoder);
+
+/**
+ * @brief get number of source symbols in the encoder window
+ */
+uint8_t get_sliding_window_count (sliding_encoder_t* encoder);
+
+/**
+ * @brief append a source symbol to the encoder window, return its sequence
+ */
+uint16_t sliding_encoder_push (sliding_encoder_t* encoder, uint8_t* symbol);
+
+/**
+ * @brief drop all symbols before the window edge acknowledged by the receiver
+ */
+void sliding_encoder_ack (sliding_encoder_t* encoder, uint16_t window_edge);
+
+/**
+ * @brief write a systematic packet of a symbol in the window, return packet length
+ */
+uint16_t produce_sliding_systematic (sliding_encoder_t* encoder, uint16_t seq, uint8_t* packet);
+
+/**
+ * @brief write a repair packet combining the whole window, return packet length
+ */
+uint16_t produce_sliding_repair (sliding_encoder_t* encoder, uint8_t* packet);
+
+/**
+ * @brief initialize a sliding window decoder
+ */
+void init_sliding_decoder (sliding_decoder_t* decoder, uint16_t symbol_size);
+
+/**
+ * @brief feed a systematic or repair packet into the decoder, return true if innovative
+ */
+bool sliding_decoder_consume (sliding_decoder_t* decoder, uint8_t* packet, uint16_t length);
+
+/**
+ * @brief copy the next in-order decoded symbol, return false if none is available
+ */
+bool sliding_decoder_read (sliding_decoder_t* decoder, uint8_t* symbol, uint16_t* seq);
+
+/**
+ * @brief get the window edge to acknowledge
+ */
+uint16_t get_sliding_window_edge (sliding_decoder_t* decoder);
+
+#endif /* SLIDING_WINDOW_H */
@@ -0,0 +1,40 @@
+#ifndef SPARSE_SCHEDULE_H
+#define SPARSE_SCHEDULE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SPARSE_DEFAULT_DEPENDENCE   0.05    // non-innovative probability a coded symbol is allowed
+
+typedef struct
+{
+    uint16_t generation_size;
+    float min_density;      // one expected non-zero coefficient
+    float max_density;      // 1 - 1/q, the density of a uniformly random vector
+    float dependence;       // target probability that a coded symbol is not innovative
+} sparse_schedule_t;
+
+/**
+ * @brief set up a rank driven density schedule for a generation over GF(2^field_bits)
+ */
+void init_sparse_schedule (sparse_schedule_t* schedule,
+                           uint16_t generation_size,
+                           uint8_t field_bits,
+                           float dependence);
+
+/**
+ * @brief get the density of the next coded symbol for a receiver of the given rank,
+ *        low while the receiver misses many symbols and dense close to full rank
+ */
+float get_sparse_density (sparse_schedule_t* schedule, float rank);
+
+/**
+ * @brief estimate the receiver rank from its last report and the packets
+ *        produced since then, each received with probability 1 - loss
+ */
+float estimate_remote_rank (uint16_t generation_size,
+                            uint16_t reported_rank,
+                            uint16_t tx_since_report,
+                            float loss);
+
+#endif /* SPARSE_SCHEDULE_H */
@@ -0,0 +1,67 @@
+#ifndef TX_RING_H
+#define TX_RING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "lowpan.h"
+#include "fec.h"
+
+#define TX_RING_LENGTH          8
+
+typedef struct
+{
+    virtual_packet_t frames[FEC_MAX_FRAG_NUM];  // framed and fragmented, ready to write
+    uint8_t frame_num;
+    uint8_t generation_id;
+    uint8_t flags;                              // NC header flags of the packet
+    bool valid;                                 // cleared when its generation is retired
+} tx_ring_entry_t;
+
+typedef struct
+{
+    tx_ring_entry_t entries[TX_RING_LENGTH];
+    uint8_t write_index;
+    uint8_t read_index;
+    uint8_t count;
+    uint8_t depth;          // packets precomputed ahead of the pacer
+    uint8_t frame_cursor;   // next frame of the entry at read_index
+} tx_ring_t;
+
+/**
+ * @brief initialize a ring of precomputed packets
+ */
+void init_tx_ring (tx_ring_t* ring, uint8_t depth);
+
+/**
+ * @brief check if the ring holds no frame to send
+ */
+bool is_tx_ring_empty (tx_ring_t* ring);
+
+/**
+ * @brief check if the producer has to wait for the pacer
+ */
+bool is_tx_ring_full (tx_ring_t* ring);
+
+/**
+ * @brief get the entry the producer fills next
+ */
+tx_ring_entry_t* get_tx_ring_tail (tx_ring_t* ring);
+
+/**
+ * @brief hand the filled tail entry over to the pacer
+ */
+void tx_ring_push (tx_ring_t* ring);
+
+/**
+ * @brief take the next frame to send, return NULL if the ring is empty
+ *        entry is set to the packet the frame belongs to, last is set on its last frame
+ */
+virtual_packet_t* tx_ring_next_frame (tx_ring_t* ring, tx_ring_entry_t** entry, bool* last);
+
+/**
+ * @brief drop all queued packets of a generation
+ */
+void tx_ring_drop_generation (tx_ring_t* ring, uint8_t generation_id);
+
+#endif /* TX_RING_H */
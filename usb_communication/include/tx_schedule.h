@@ -0,0 +1,44 @@
+#ifndef TX_SCHEDULE_H
+#define TX_SCHEDULE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TX_SCHEDULE_LENGTH      1024    // positions planned per generation, later ones are repair
+#define TX_SCHEDULE_REPAIR      -1      // a coded repair symbol
+
+typedef enum
+{
+    SCHEDULE_SEQUENTIAL = 0,    // every systematic symbol first, then repair
+    SCHEDULE_INTERLEAVED = 1,   // one repair symbol after every interval systematic ones
+    SCHEDULE_RANDOM = 2,        // random permutation of systematic and repair symbols
+} tx_schedule_type_t;
+
+typedef struct
+{
+    uint8_t type;
+    uint16_t interval;                      // SCHEDULE_INTERLEAVED
+    int16_t order[TX_SCHEDULE_LENGTH];      // systematic index or TX_SCHEDULE_REPAIR per position
+} tx_schedule_t;
+
+/**
+ * @brief plan the transmit order of a generation,
+ *        a random schedule permutes the first tx_num positions
+ */
+void build_tx_schedule (tx_schedule_t* schedule,
+                        uint8_t type,
+                        uint16_t interval,
+                        uint16_t generation_size,
+                        uint16_t tx_num);
+
+/**
+ * @brief get the systematic index sent at a position, or TX_SCHEDULE_REPAIR
+ */
+int16_t get_scheduled_symbol (tx_schedule_t* schedule, uint16_t position);
+
+/**
+ * @brief get a printable schedule name
+ */
+const char* get_tx_schedule_name (uint8_t type);
+
+#endif /* TX_SCHEDULE_H */
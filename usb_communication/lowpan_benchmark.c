@@ -0,0 +1,441 @@
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <stdint.h>
+#include <time.h>
+#include <stdlib.h>
+
+#include "serial.h"
+#include "utils.h"
+#include "lowpan.h"
+#include "reassemble.h"
+#include "fec.h"
+
+#define LOG_FILE        "benchmark.dump"
+#define MAX_FLOW_NUM    8
+#define MAX_CHANNEL_LEN (MAX_FLOW_NUM * FEC_MAX_FRAG_NUM * 2)
+#define GENERATION_SIZE 10
+
+static struct option long_options[] =
+{
+    {"iterations",  required_argument, 0, 'n'},
+    {"logFile",     required_argument, 0, 'l'},
+    {"help",        no_argument,       0, 'h'},
+    {0, 0, 0, 0}
+};
+
+void usage(void)
+{
+    printf ("Usage: [-n --iterations <datagrams per configuration>] [-l --logFile <log file name>] [-h --help]\n");
+    printf ("Options:\n");
+    printf ("\t-n --iterations\tdatagrams per configuration\tDefault: 2000\n");
+    printf ("\t-l --logFile\tlog file name\t\t\tDefault: benchmark.dump\n");
+    printf ("\t-h --help\tthis help documetation\n");
+}
+
+typedef enum
+{
+    PATTERN_NONE,
+    PATTERN_REORDER,
+    PATTERN_DUPLICATE,
+} channel_pattern_t;
+
+static const char* pattern_names[] = {"none", "reorder", "duplicate"};
+
+// benchmark sweep
+static const uint16_t payload_sizes[] = {50, 100, 200, 400, 800, 1200};
+static const float loss_rates[] = {0, 0.05, 0.1, 0.2};
+static const channel_pattern_t patterns[] = {PATTERN_NONE, PATTERN_REORDER, PATTERN_DUPLICATE};
+static const uint8_t flow_nums[] = {1, 2, 4};
+static const uint8_t parity_nums[] = {0, 2};
+static const uint8_t compare_parity_nums[] = {1, 2, 4};
+static const float pattern_probability = 0.2;
+
+/**
+ * @brief get monotonic time in ns
+ */
+uint64_t get_time_ns (void)
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/**
+ * @brief draw a random event with a given probability
+ */
+bool random_event (float probability)
+{
+    return (float)rand () / RAND_MAX < probability;
+}
+
+/**
+ * @brief build a datagram with IPHC/UDP placeholders and a flow specific pattern
+ */
+void generate_datagram (uint8_t* datagram, uint16_t length, uint8_t flow)
+{
+    for (uint16_t i = 0; i < length; i++)
+        datagram[i] = (uint8_t)(flow * 31 + i);
+    set_ip_header (datagram);
+    set_udp_header (datagram + IPHC_TOTAL_SIZE);
+}
+
+/**
+ * @brief fragment a datagram into frames, return the number of frames
+ */
+uint8_t fragment_datagram (virtual_packet_t tx_packet[],
+                           uint8_t* datagram,
+                           uint16_t length,
+                           uint8_t parity_num)
+{
+    if (need_fragmentation (length) == false)
+    {
+        generate_normal_packet (&tx_packet[0], datagram, length);
+        return 1;
+    }
+    if (parity_num > 0)
+        return do_fec_fragmentation (tx_packet, datagram, length, parity_num);
+    do_fragmentation (tx_packet, datagram, length);
+    return get_fragment_num ();
+}
+
+/**
+ * @brief push the frames of concurrent flows through a lossy channel
+ */
+uint16_t apply_channel (virtual_packet_t* channel[],
+                        virtual_packet_t tx_packet[][FEC_MAX_FRAG_NUM],
+                        uint8_t frame_num,
+                        uint8_t flow_num,
+                        float loss_rate,
+                        channel_pattern_t pattern)
+{
+    uint16_t channel_length = 0;
+    virtual_packet_t* frame = NULL;
+    // interleave flows frame by frame
+    for (uint8_t i = 0; i < frame_num; i++)
+        for (uint8_t f = 0; f < flow_num; f++)
+        {
+            if (random_event (loss_rate) == true)
+                continue;
+            frame = &tx_packet[f][i];
+            channel[channel_length++] = frame;
+            if (pattern == PATTERN_DUPLICATE && random_event (pattern_probability) == true)
+                channel[channel_length++] = frame;
+        }
+    // swap neighbouring frames
+    if (pattern == PATTERN_REORDER)
+        for (uint16_t i = 0; i + 1 < channel_length; i++)
+            if (random_event (pattern_probability) == true)
+            {
+                frame = channel[i];
+                channel[i] = channel[i + 1];
+                channel[i + 1] = frame;
+                i++;
+            }
+    return channel_length;
+}
+
+/**
+ * @brief feed one frame into the receive path, return datagram length once complete
+ */
+uint16_t receive_frame (uint8_t* frame, uint16_t length, uint8_t* extract_buf)
+{
+    // FEC fragment
+    if (is_fec_fragment (frame) == true)
+    {
+        if (read_fec_fragment (frame, length) == false ||
+            is_fec_reassemble_complete () == false)
+            return 0;
+        return extract_fec_packet (extract_buf);
+    }
+    // non-fragmented/normal packet
+    if (need_reassemble (frame) == false)
+    {
+        memcpy (extract_buf, frame, length);
+        return length;
+    }
+    if (is_frame_format_correct (frame) == false)
+    {
+        init_reassembler ();
+        return 0;
+    }
+    if (reassemble_fragment (frame, length) == false ||
+        is_reassemble_complete () == false)
+        return 0;
+    extract_packet (extract_buf);
+    length = get_reassembler ()->filled_size;
+    init_reassembler ();
+    return length;
+}
+
+/**
+ * @brief measure the fragmenter for one payload size
+ */
+void benchmark_fragmentation (FILE* fp, uint16_t payload_size, uint32_t iterations)
+{
+    uint8_t datagram[MAX_PACKET_SIZE];
+    virtual_packet_t tx_packet[FEC_MAX_FRAG_NUM];
+    uint64_t fragment_count = 0;
+    uint64_t start, elapsed;
+
+    generate_datagram (datagram, payload_size, 0);
+    start = get_time_ns ();
+    for (uint32_t i = 0; i < iterations; i++)
+        fragment_count += fragment_datagram (tx_packet, datagram, payload_size, 0);
+    elapsed = get_time_ns () - start;
+
+    printf ("fragment   size %4u: %10.0f datagrams/s %8.1f ns/fragment\n",
+            payload_size,
+            iterations * 1e9 / elapsed,
+            (double)elapsed / fragment_count);
+    fprintf (fp, "{\"type\": \"lowpan_bench\", \"stage\": \"fragment\", \"payload_size\": %u, \"fragment_num\": %lu, \"datagrams_per_s\": %.0f, \"ns_per_fragment\": %.1f },\n",
+             payload_size,
+             (unsigned long)(fragment_count / iterations),
+             iterations * 1e9 / elapsed,
+             (double)elapsed / fragment_count);
+}
+
+/**
+ * @brief measure the reassembler for one channel configuration
+ */
+void benchmark_reassembly (FILE* fp,
+                           uint16_t payload_size,
+                           float loss_rate,
+                           channel_pattern_t pattern,
+                           uint8_t flow_num,
+                           uint8_t parity_num,
+                           uint32_t iterations)
+{
+    static virtual_packet_t tx_packet[MAX_FLOW_NUM][FEC_MAX_FRAG_NUM];
+    static uint8_t datagram[MAX_FLOW_NUM][MAX_PACKET_SIZE];
+    virtual_packet_t* channel[MAX_CHANNEL_LEN];
+    uint8_t extract_buf[MAX_PACKET_SIZE];
+    uint16_t channel_length = 0;
+    uint16_t length = 0;
+    uint8_t frame_num = 0;
+    uint64_t frame_count = 0;
+    uint32_t delivered = 0;
+    uint32_t corrupt = 0;
+    uint64_t elapsed = 0;
+    uint64_t start;
+
+    for (uint8_t f = 0; f < flow_num; f++)
+        generate_datagram (datagram[f], payload_size, f);
+
+    init_reassembler ();
+    init_fec_reassembler ();
+    for (uint32_t i = 0; i < iterations; i += flow_num)
+    {
+        // channel simulation is not part of the measurement
+        for (uint8_t f = 0; f < flow_num; f++)
+            frame_num = fragment_datagram (tx_packet[f], datagram[f], payload_size, parity_num);
+        channel_length = apply_channel (channel, tx_packet, frame_num, flow_num, loss_rate, pattern);
+
+        start = get_time_ns ();
+        for (uint16_t j = 0; j < channel_length; j++)
+        {
+            length = receive_frame (channel[j]->packet, channel[j]->length, extract_buf);
+            if (length == 0)
+                continue;
+            // match the datagram against all flows
+            uint8_t f = 0;
+            while (f < flow_num &&
+                   (length != payload_size ||
+                    memcmp (extract_buf + 1, datagram[f] + 1, payload_size - 1) != 0))
+                f++;
+            if (f < flow_num)
+                delivered++;
+            else
+                corrupt++;
+        }
+        elapsed += get_time_ns () - start;
+        frame_count += channel_length;
+    }
+
+    if (frame_count == 0)
+        frame_count = 1;
+    if (elapsed == 0)
+        elapsed = 1;
+    printf ("reassemble size %4u loss %.2f %-9s flows %u parity %u: %10.0f datagrams/s %8.1f ns/fragment delivery %.3f corrupt %u\n",
+            payload_size,
+            loss_rate,
+            pattern_names[pattern],
+            flow_num,
+            parity_num,
+            delivered * 1e9 / elapsed,
+            (double)elapsed / frame_count,
+            (float)delivered / iterations,
+            corrupt);
+    fprintf (fp, "{\"type\": \"lowpan_bench\", \"stage\": \"reassemble\", \"payload_size\": %u, \"loss_rate\": %.2f, \"pattern\": \"%s\", \"flows\": %u, \"parity\": %u, \"datagrams_per_s\": %.0f, \"ns_per_fragment\": %.1f, \"delivery_ratio\": %.3f, \"corrupt_num\": %u },\n",
+             payload_size,
+             loss_rate,
+             pattern_names[pattern],
+             flow_num,
+             parity_num,
+             delivered * 1e9 / elapsed,
+             (double)elapsed / frame_count,
+             (float)delivered / iterations,
+             corrupt);
+}
+
+/**
+ * @brief deliver datagrams through a lossy channel, return delivered count
+ */
+uint32_t transfer_datagrams (uint8_t* datagram,
+                             uint16_t payload_size,
+                             float loss_rate,
+                             uint8_t parity_num,
+                             uint32_t datagram_num)
+{
+    static virtual_packet_t tx_packet[1][FEC_MAX_FRAG_NUM];
+    virtual_packet_t* channel[MAX_CHANNEL_LEN];
+    uint8_t extract_buf[MAX_PACKET_SIZE];
+    uint16_t channel_length = 0;
+    uint8_t frame_num = 0;
+    uint32_t delivered = 0;
+
+    for (uint32_t d = 0; d < datagram_num; d++)
+    {
+        frame_num = fragment_datagram (tx_packet[0], datagram, payload_size, parity_num);
+        channel_length = apply_channel (channel, tx_packet, frame_num, 1, loss_rate, PATTERN_NONE);
+        for (uint16_t j = 0; j < channel_length; j++)
+            if (receive_frame (channel[j]->packet, channel[j]->length, extract_buf) == payload_size)
+                delivered++;
+    }
+    return delivered;
+}
+
+/**
+ * @brief compare fragment-level FEC against symbol-level redundancy at equal airtime
+ */
+void benchmark_fec_compare (FILE* fp,
+                            uint16_t payload_size,
+                            float loss_rate,
+                            uint8_t parity_num,
+                            uint32_t trials)
+{
+    static virtual_packet_t tx_packet[FEC_MAX_FRAG_NUM];
+    uint8_t datagram[MAX_PACKET_SIZE];
+    uint8_t plain_frame_num = 0;
+    uint8_t fec_frame_num = 0;
+    uint32_t airtime = 0;
+    uint32_t symbol_datagram_num = 0;
+    uint32_t symbol_success = 0;
+    uint32_t fec_success = 0;
+
+    generate_datagram (datagram, payload_size, 0);
+    plain_frame_num = fragment_datagram (tx_packet, datagram, payload_size, 0);
+    fec_frame_num = fragment_datagram (tx_packet, datagram, payload_size, parity_num);
+    // both schemes spend the same number of frames per generation
+    airtime = GENERATION_SIZE * fec_frame_num;
+    symbol_datagram_num = airtime / plain_frame_num;
+
+    init_reassembler ();
+    init_fec_reassembler ();
+    for (uint32_t t = 0; t < trials; t++)
+    {
+        // a generation decodes once any generation size symbols arrive
+        if (transfer_datagrams (datagram, payload_size, loss_rate, 0, symbol_datagram_num) >= GENERATION_SIZE)
+            symbol_success++;
+        // with fragment-level FEC and no repair symbols, every symbol must arrive
+        if (transfer_datagrams (datagram, payload_size, loss_rate, parity_num, GENERATION_SIZE) >= GENERATION_SIZE)
+            fec_success++;
+    }
+
+    if (trials == 0)
+        trials = 1;
+    printf ("compare    size %4u loss %.2f parity %u: frames %u symbol redundancy %.2f decode %.3f, fec decode %.3f\n",
+            payload_size,
+            loss_rate,
+            parity_num,
+            airtime,
+            (float)symbol_datagram_num / GENERATION_SIZE - 1,
+            (float)symbol_success / trials,
+            (float)fec_success / trials);
+    fprintf (fp, "{\"type\": \"lowpan_bench\", \"stage\": \"fec_compare\", \"payload_size\": %u, \"loss_rate\": %.2f, \"gen_size\": %u, \"parity\": %u, \"frames\": %u, \"symbol_redundancy\": %.2f, \"symbol_decode_prob\": %.3f, \"fec_decode_prob\": %.3f },\n",
+             payload_size,
+             loss_rate,
+             GENERATION_SIZE,
+             parity_num,
+             airtime,
+             (float)symbol_datagram_num / GENERATION_SIZE - 1,
+             (float)symbol_success / trials,
+             (float)fec_success / trials);
+}
+
+int main(int argc, char *argv[])
+{
+    char* log_file_name = (char*)LOG_FILE;
+    uint32_t iterations = 2000;
+
+    // cmd arguments parsing
+    int opt;
+    int option_index = 0;
+
+    while ((opt = getopt_long (argc, argv, "n:l:h", long_options, &option_index)) != -1)
+    {
+        switch (opt)
+        {
+            case 'n':
+                iterations = atoi (optarg);
+                break;
+            case 'l':
+                log_file_name = optarg;
+                break;
+            case 'h':
+                usage ();
+                return 0;
+            default:
+                usage ();
+                return 0;
+        }
+    }
+
+    // fixed seed for reproducible channel patterns
+    srand (1);
+
+    FILE* fp = fopen (log_file_name, "a+");
+    if (fp == NULL)
+    {
+        fprintf (stderr, "error %d opening %s: %s\n", errno, log_file_name, strerror (errno));
+        return -1;
+    }
+
+    for (uint8_t s = 0; s < sizeof payload_sizes / sizeof payload_sizes[0]; s++)
+        benchmark_fragmentation (fp, payload_sizes[s], iterations);
+
+    for (uint8_t s = 0; s < sizeof payload_sizes / sizeof payload_sizes[0]; s++)
+        for (uint8_t l = 0; l < sizeof loss_rates / sizeof loss_rates[0]; l++)
+            for (uint8_t p = 0; p < sizeof patterns / sizeof patterns[0]; p++)
+                for (uint8_t f = 0; f < sizeof flow_nums / sizeof flow_nums[0]; f++)
+                    for (uint8_t r = 0; r < sizeof parity_nums / sizeof parity_nums[0]; r++)
+                    {
+                        // parity fragments only apply to fragmented datagrams
+                        if (parity_nums[r] > 0 && need_fragmentation (payload_sizes[s]) == false)
+                            continue;
+                        benchmark_reassembly (fp,
+                                              payload_sizes[s],
+                                              loss_rates[l],
+                                              patterns[p],
+                                              flow_nums[f],
+                                              parity_nums[r],
+                                              iterations);
+                    }
+
+    for (uint8_t s = 0; s < sizeof payload_sizes / sizeof payload_sizes[0]; s++)
+        for (uint8_t l = 0; l < sizeof loss_rates / sizeof loss_rates[0]; l++)
+            for (uint8_t r = 0; r < sizeof compare_parity_nums / sizeof compare_parity_nums[0]; r++)
+            {
+                if (need_fragmentation (payload_sizes[s]) == false)
+                    continue;
+                benchmark_fec_compare (fp,
+                                       payload_sizes[s],
+                                       loss_rates[l],
+                                       compare_parity_nums[r],
+                                       iterations / GENERATION_SIZE);
+            }
+    fclose (fp);
+    return 0;
+}
@@ -0,0 +1,171 @@
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <stdint.h>
+#include <sys/time.h>
+#include <time.h>
+#include <stdlib.h>
+
+#include "serial.h"
+#include "utils.h"
+#include "lowpan.h"
+#include "reassemble.h"
+#include "config.h"
+
+#define USB_DEVICE  "/dev/ttyACM0"
+#define LOG_FILE    "log.dump"
+
+static struct option long_options[] =
+{
+    {"port",        required_argument, 0, 'p'},
+    {"address",     required_argument, 0, 'a'},
+    {"timeout",     required_argument, 0, 't'},
+    {"logFile",     required_argument, 0, 'l'},
+    {"help",        no_argument,       0, 'h'},
+    {0, 0, 0, 0}
+};
+
+void usage(void)
+{
+    printf ("Usage: [-p --port <serial port number>] [-a --address <mesh short address>] [-t --timeout <rx timeout in ms>] [-l --logFile <log file name>] [-h --help]\n");
+    printf ("Options:\n");
+    printf ("\t-p --port\tserial port number to open\tDefault: /dev/ttyACM0\n");
+    printf ("\t-a --address\tmesh short address of the relay\tDefault: 11\n");
+    printf ("\t-t --timeout\trx timeout in ms\t\tDefault: 1000\n");
+    printf ("\t-l --logFile\tlog file name\t\t\tDefault: log.dump\n");
+    printf ("\t-h --help\tthis help documetation\n");
+}
+
+int write_measurement_log (char* log_file_name,
+                           uint16_t address,
+                           uint16_t rx_frame_count,
+                           uint16_t fwd_frame_count,
+                           uint16_t drop_frame_count)
+{
+    FILE* fp;
+    fp = fopen (log_file_name, "a+");
+    if (fp == NULL)
+    {
+        fprintf (stderr, "error %d opening %s: %s\n", errno, log_file_name, strerror (errno));
+        return -1;
+    }
+
+    fprintf(fp, "{\"type\": \"mesh_relay\", \"address\": %u, \"rx_num\": %u, \"fwd_num\": %u, \"drop_num\": %u },\n",
+            address,
+            rx_frame_count,
+            fwd_frame_count,
+            drop_frame_count);
+    fclose(fp);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    char* serial_port = (char*)USB_DEVICE;
+    char* log_file_name = (char*)LOG_FILE;
+    uint16_t address = 11;
+    uint32_t rx_timeout = 1000; // ms
+
+    // cmd arguments parsing
+    int opt;
+    int option_index = 0;
+
+    while ((opt = getopt_long (argc, argv, "p:a:t:l:h", long_options, &option_index)) != -1)
+    {
+        switch (opt)
+        {
+            case 'p':
+                serial_port = optarg;
+                break;
+            case 'a':
+                address = atoi (optarg);
+                break;
+            case 't':
+                rx_timeout = atoi (optarg);
+                break;
+            case 'l':
+                log_file_name = optarg;
+                break;
+            case 'h':
+                usage ();
+                return 0;
+            default:
+                usage ();
+                return 0;
+        }
+    }
+
+    // USB communication
+    int fd = open_serial_port (serial_port, B115200, 0);
+    if (fd < 0)
+    {
+        fprintf (stderr, "error %d opening %s: %s\n", errno, serial_port, strerror (errno));
+        return -1;
+    }
+
+    uint32_t inter_frame_interval = 30000; // inter frame interval in us
+    int ret;
+    int rx_num = 0;
+    uint16_t rx_frame_count = 0;
+    uint16_t fwd_frame_count = 0;
+    uint16_t drop_frame_count = 0;
+    uint8_t rx_buf[MAX_PACKET_SIZE];
+    memset (rx_buf, 0, sizeof rx_buf);
+
+    // time related variable definition
+    clock_t rx_timeout_start = 0;
+
+    set_mesh_address (address);
+
+    rx_timeout_start = clock();
+    // relay operations
+    while ((clock() - rx_timeout_start) * 1000 / CLOCKS_PER_SEC < rx_timeout)
+    {
+        // receive a frame, no reassembly is needed for header routing
+        rx_num = read_serial_port (fd, rx_buf, &rx_frame_count, true);
+        if (rx_num == 0)
+            continue;
+        // only mesh addressed frames are routed
+        if (has_mesh_header (rx_buf) == false ||
+            get_mesh_final_destination (rx_buf) == address ||
+            get_mesh_originator (rx_buf) == address)
+        {
+            drop_frame_count++;
+            continue;
+        }
+        // hop limit reached
+        if (decrement_mesh_hops_left (rx_buf) == false)
+        {
+            printf ("[relay] hops left exhausted, drop a frame\n");
+            drop_frame_count++;
+            continue;
+        }
+        ret = write_serial_port (fd, rx_buf, rx_num);
+        if (ret < 0)
+            return -1;
+        printf ("[relay] forward a frame from %u to %u, hops left: %u\n",
+                get_mesh_originator (rx_buf),
+                get_mesh_final_destination (rx_buf),
+                get_mesh_hops_left (rx_buf));
+        fwd_frame_count++;
+        memset (rx_buf, 0, sizeof rx_buf);
+        usleep (inter_frame_interval);
+    } // end of while
+
+    printf ("[relay] frame total receive: %u\n", rx_frame_count);
+    printf ("[relay] frame total forward: %u\n", fwd_frame_count);
+    printf ("[relay] frame total drop: %u\n", drop_frame_count);
+
+    // write log to json file
+    ret = write_measurement_log (log_file_name,
+                                 address,
+                                 rx_frame_count,
+                                 fwd_frame_count,
+                                 drop_frame_count);
+    if (ret < 0)
+        return -1;
+    return 0;
+}
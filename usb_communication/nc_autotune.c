@@ -0,0 +1,126 @@
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "lowpan.h"
+#include "autotune.h"
+#include "nc_field.h"
+
+static struct option long_options[] =
+{
+    {"payload",     required_argument, 0, 'z'},
+    {"field",       required_argument, 0, 'f'},
+    {"seed",        no_argument,       0, 'v'},
+    {"extraHeader", required_argument, 0, 'e'},
+    {"loss",        required_argument, 0, 'o'},
+    {"target",      required_argument, 0, 'q'},
+    {"maxGenSize",  required_argument, 0, 'g'},
+    {"help",        no_argument,       0, 'h'},
+    {0, 0, 0, 0}
+};
+
+void usage(void)
+{
+    printf ("Usage: [-z --payload <bytes>] [-f --field <finite field>] [-v --seed] [-e --extraHeader <bytes>] [-o --loss <loss in percent>] [-q --target <decode probability in percent>] [-g --maxGenSize <generation size>] [-h --help]\n");
+    printf ("Options:\n");
+    printf ("\t-z --payload\tbytes to transfer\t\tDefault: 0 (stream)\n");
+    printf ("\t-f --field\tbinary, binary4, binary8, binary16 or prime2325\tDefault: binary8\n");
+    printf ("\t-v --seed\tcoded packets carry a seed instead of the coding vector\n");
+    printf ("\t-e --extraHeader\tbytes added in front of every packet, 5 for a mesh header\tDefault: 0\n");
+    printf ("\t-o --loss\tpacket loss rate in percent\tDefault: 10\n");
+    printf ("\t-q --target\ttarget decode probability in percent\tDefault: 99\n");
+    printf ("\t-g --maxGenSize\tlargest generation size to consider\tDefault: 64\n");
+    printf ("\t-h --help\tthis help documetation\n");
+}
+
+int main(int argc, char *argv[])
+{
+    autotune_input_t input;
+    autotune_result_t result;
+    uint8_t field_id = NC_FIELD_DEFAULT;
+
+    memset (&input, 0, sizeof input);
+    input.vector_format = AUTOTUNE_FULL_VECTOR;
+    input.loss = 0.1;
+    input.target = 0.99;
+    input.max_generation_size = AUTOTUNE_DEFAULT_MAX_GEN_SIZE;
+
+    // cmd arguments parsing
+    int opt;
+    int option_index = 0;
+
+    while ((opt = getopt_long (argc, argv, "z:f:ve:o:q:g:h", long_options, &option_index)) != -1)
+    {
+        switch (opt)
+        {
+            case 'z':
+                input.payload_size = atoi (optarg);
+                break;
+            case 'f':
+                if (parse_field_name (optarg, &field_id) == false)
+                {
+                    fprintf (stderr, "unknown finite field %s\n", optarg);
+                    return -1;
+                }
+                break;
+            case 'v':
+                input.vector_format = AUTOTUNE_SEED_VECTOR;
+                break;
+            case 'e':
+                input.extra_header_size = atoi (optarg);
+                break;
+            case 'o':
+                input.loss = (float)atoi (optarg) / 100;
+                break;
+            case 'q':
+                input.target = (float)atoi (optarg) / 100;
+                break;
+            case 'g':
+                input.max_generation_size = atoi (optarg);
+                break;
+            case 'h':
+                usage ();
+                return 0;
+            default:
+                usage ();
+                return 0;
+        }
+    }
+
+    input.field_bits = get_field_bits (field_id);
+    if (autotune_coding (&input, &result) == false)
+    {
+        fprintf (stderr, "no configuration reaches the target without fragmentation\n");
+        return -1;
+    }
+
+    printf ("---------autotune result---------\n");
+    printf ("symbol size:\t\t%u\n", result.symbol_size);
+    printf ("generation size:\t%u\n", result.generation_size);
+    printf ("tx packets:\t\t%u\n", result.tx_num);
+    printf ("redundancy:\t\t%u%%\n", result.redundancy);
+    printf ("packet size:\t\t%u/%u\n", result.packet_size, MAX_MSDU_SIZE);
+    printf ("decode probability:\t%.4f\n", result.decode_probability);
+    printf ("frames:\t\t\t%u\n", result.frame_num);
+    printf ("goodput:\t\t%.2f bytes/frame\n", result.goodput);
+    printf ("---------autotune result---------\n");
+    // relays and server decode the same field, the default one needs no option
+    char field_option[32] = "";
+    if (field_id != NC_FIELD_DEFAULT)
+        snprintf (field_option, sizeof field_option, " -F %s", get_field_name (field_id));
+    printf ("client options: -s %u -g %u -r %u%s%s\n",
+            result.symbol_size,
+            result.generation_size,
+            result.redundancy,
+            input.vector_format == AUTOTUNE_SEED_VECTOR ? " -v" : "",
+            field_option);
+    printf ("relay and server options: -s %u -g %u%s\n",
+            result.symbol_size,
+            result.generation_size,
+            field_option);
+    return 0;
+}
@@ -0,0 +1,865 @@
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <stdint.h>
+#include <time.h>
+#include <stdlib.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "lowpan.h"
+#include "nc_header.h"
+#include "nc_field.h"
+#include "tx_schedule.h"
+#include "sparse_schedule.h"
+#include "rank_tracker.h"
+#include "recoder_cache.h"
+
+#include <kodo_rlnc/coders.hpp>
+
+#define LOG_FILE        "benchmark.dump"
+#define SCHEDULE_GEN_SIZE       16
+#define SCHEDULE_SYMBOL_SIZE    16
+#define SCHEDULE_REDUNDANCY     0.3
+#define FIELD_GEN_SIZE          16
+#define FIELD_CODED_NUM         (4 * FIELD_GEN_SIZE)    // coded symbols buffered per generation
+#define SPARSE_GEN_SIZE         32
+#define SPARSE_SYMBOL_SIZE      64
+#define SPARSE_REPORT_INTERVAL  4       // coded packets per rank report
+#define DEPTH_GEN_SIZE          32
+#define DEPTH_SYMBOL_SIZE       64
+#define DEPTH_FIRST_LOSS        0.1     // source to relay
+#define DEPTH_SECOND_LOSS       0.3     // relay to destination, the lossier hop
+#define RELAY_GEN_SIZE          32
+#define RELAY_SYMBOL_SIZE       64
+#define RELAY_FIRST_LOSS        0.05    // source to relay
+
+static struct option long_options[] =
+{
+    {"iterations",  required_argument, 0, 'n'},
+    {"logFile",     required_argument, 0, 'l'},
+    {"help",        no_argument,       0, 'h'},
+    {0, 0, 0, 0}
+};
+
+void usage(void)
+{
+    printf ("Usage: [-n --iterations <generations per configuration>] [-l --logFile <log file name>] [-h --help]\n");
+    printf ("Options:\n");
+    printf ("\t-n --iterations\tgenerations per configuration\tDefault: 200\n");
+    printf ("\t-l --logFile\tlog file name\t\t\tDefault: benchmark.dump\n");
+    printf ("\t-h --help\tthis help documetation\n");
+}
+
+// benchmark sweep, symbol sizes from the default up to fragmented symbols
+static const uint16_t symbol_sizes[] = {4, 16, 64, 100, 400};
+static const uint16_t generation_sizes[] = {4, 10, 16, 32};
+
+// Gilbert-Elliott channels, good to bad and bad to good transition probabilities
+static const float burst_channels[][2] = {{0.05, 0.5}, {0.05, 0.2}, {0.1, 0.4}};
+// transmit schedules, type and interval
+static const uint16_t schedules[][2] = {{SCHEDULE_SEQUENTIAL, 0},
+                                        {SCHEDULE_INTERLEAVED, 2},
+                                        {SCHEDULE_INTERLEAVED, 4},
+                                        {SCHEDULE_RANDOM, 0}};
+// symbol sizes of the per-field comparison, unfragmented frames
+static const uint16_t field_symbol_sizes[] = {4, 16, 64};
+// fixed densities against rank driven schedules with these non-innovative targets
+static const float fixed_densities[] = {0.05, 0.1, 0.2, 0.5, 0.99};
+static const float schedule_dependences[] = {0.01, 0.05, 0.2};
+// coded symbols a relay recoder stores, up to the whole generation
+static const uint16_t recoder_depths[] = {2, 4, 8, 16, 24, 32};
+// second hop losses of the relay mode comparison, from as good as the first hop to much worse
+static const float second_hop_losses[] = {0.05, 0.2, 0.4};
+
+typedef struct
+{
+    float good_to_bad;
+    float bad_to_good;
+    bool bad;       // every packet is lost in the bad state, none in the good state
+} gilbert_elliott_t;
+
+/**
+ * @brief get monotonic time in ns
+ */
+uint64_t get_time_ns (void)
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/**
+ * @brief get CPU cycle counter, 0 where it is not available
+ */
+uint64_t get_cycles (void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc ();
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief move a Gilbert-Elliott channel one packet on, return true if the packet is lost
+ */
+bool gilbert_elliott_loss (gilbert_elliott_t* channel)
+{
+    float event = (float)rand () / RAND_MAX;
+    if (channel->bad == true && event < channel->bad_to_good)
+        channel->bad = false;
+    else if (channel->bad == false && event < channel->good_to_bad)
+        channel->bad = true;
+    return channel->bad;
+}
+
+/**
+ * @brief write one result line
+ */
+void report_result (FILE* fp,
+                    const char* stage,
+                    uint16_t symbol_size,
+                    uint16_t generation_size,
+                    uint64_t symbol_count,
+                    uint64_t elapsed,
+                    uint64_t cycles)
+{
+    printf ("%-7s size %4u gen %2u: %10.0f symbols/s %8.2f cycles/byte\n",
+            stage,
+            symbol_size,
+            generation_size,
+            symbol_count * 1e9 / elapsed,
+            (double)cycles / (symbol_count * symbol_size));
+    fprintf (fp, "{\"type\": \"nc_bench\", \"stage\": \"%s\", \"symbol_size\": %u, \"gen_size\": %u, \"symbols_per_s\": %.0f, \"ns_per_symbol\": %.1f, \"cycles_per_byte\": %.2f },\n",
+             stage,
+             symbol_size,
+             generation_size,
+             symbol_count * 1e9 / elapsed,
+             (double)elapsed / symbol_count,
+             (double)cycles / (symbol_count * symbol_size));
+}
+
+/**
+ * @brief code and decode generations one symbol at a time, as the apps did
+ *        with the symbol API and the NC header
+ */
+void benchmark_symbol (FILE* fp, uint16_t symbol_size, uint16_t generation_size, uint32_t iterations)
+{
+    fifi::finite_field field = fifi::finite_field::binary8;
+    kodo_rlnc::encoder encoder (field, generation_size, symbol_size);
+    kodo_rlnc::decoder decoder (field, generation_size, symbol_size);
+    uint8_t data_in[encoder.block_size()];
+    uint8_t data_out[decoder.block_size()];
+    uint8_t symbol[symbol_size];
+    uint8_t coefficients[encoder.coefficient_vector_size()];
+    uint8_t packet[NC_HDR_SIZE + sizeof coefficients + symbol_size];
+    uint16_t packet_length;
+    nc_header_t header;
+    uint64_t symbol_count = 0;
+    uint64_t start, elapsed, cycles;
+
+    memset (&header, 0, sizeof header);
+    for (uint32_t i = 0; i < sizeof data_in; i++)
+        data_in[i] = (uint8_t)rand ();
+    start = get_time_ns ();
+    cycles = get_cycles ();
+    for (uint32_t n = 0; n < iterations; n++)
+    {
+        encoder.reset ();
+        decoder.reset ();
+        encoder.set_symbols_storage (data_in);
+        decoder.set_symbols_storage (data_out);
+        while (decoder.is_complete() == false)
+        {
+            encoder.generate (coefficients);
+            encoder.produce_symbol (symbol, coefficients);
+            header.type = NC_CODED;
+            header.coefficients = coefficients;
+            header.coefficient_size = sizeof coefficients;
+            header.symbol = symbol;
+            header.length = symbol_size;
+            packet_length = write_nc_packet (packet, &header);
+            parse_nc_packet (packet, packet_length, sizeof coefficients, symbol_size, &header);
+            decoder.consume_symbol (header.symbol, header.coefficients);
+        }
+        symbol_count += generation_size;
+    }
+    cycles = get_cycles () - cycles;
+    elapsed = get_time_ns () - start;
+    if (memcmp (data_in, data_out, sizeof data_in) != 0)
+        fprintf (stderr, "symbol stage decoded wrong data\n");
+    report_result (fp, "symbol", symbol_size, generation_size, symbol_count, elapsed, cycles);
+}
+
+/**
+ * @brief code and decode generations with the batch payload API
+ */
+void benchmark_batch (FILE* fp, uint16_t symbol_size, uint16_t generation_size, uint32_t iterations)
+{
+    fifi::finite_field field = fifi::finite_field::binary8;
+    kodo_rlnc::encoder encoder (field, generation_size, symbol_size);
+    kodo_rlnc::decoder decoder (field, generation_size, symbol_size);
+    uint8_t data_in[encoder.block_size()];
+    uint8_t data_out[decoder.block_size()];
+    // pre-allocated payload arrays
+    uint32_t payload_size = encoder.max_payload_size();
+    uint8_t payload_data[generation_size * payload_size];
+    uint8_t* payloads[generation_size];
+    uint64_t symbol_count = 0;
+    uint64_t start, elapsed, cycles;
+
+    for (uint16_t i = 0; i < generation_size; i++)
+        payloads[i] = payload_data + i * payload_size;
+    for (uint32_t i = 0; i < sizeof data_in; i++)
+        data_in[i] = (uint8_t)rand ();
+    start = get_time_ns ();
+    cycles = get_cycles ();
+    for (uint32_t n = 0; n < iterations; n++)
+    {
+        encoder.reset ();
+        decoder.reset ();
+        // coded payloads only, like the symbol stage
+        encoder.set_systematic_off ();
+        encoder.set_symbols_storage (data_in);
+        decoder.set_symbols_storage (data_out);
+        encoder.produce_payloads (payloads, generation_size);
+        // a rank deficient batch is not consumed, top it up one payload at a time
+        if (decoder.consume_payloads (payloads, generation_size) == false)
+            for (uint16_t i = 0; i < generation_size; i++)
+                decoder.consume_payload (payloads[i]);
+        while (decoder.is_complete() == false)
+        {
+            encoder.produce_payload (payloads[0]);
+            decoder.consume_payload (payloads[0]);
+        }
+        symbol_count += generation_size;
+    }
+    cycles = get_cycles () - cycles;
+    elapsed = get_time_ns () - start;
+    if (memcmp (data_in, data_out, sizeof data_in) != 0)
+        fprintf (stderr, "batch stage decoded wrong data\n");
+    report_result (fp, "batch", symbol_size, generation_size, symbol_count, elapsed, cycles);
+}
+
+/**
+ * @brief send generations over a burst loss channel in a transmit schedule,
+ *        measure decoding delay and in-order symbol delivery delay in packets
+ */
+void benchmark_schedule (FILE* fp,
+                         uint8_t type,
+                         uint16_t interval,
+                         const float* burst_channel,
+                         uint32_t iterations)
+{
+    fifi::finite_field field = fifi::finite_field::binary8;
+    kodo_rlnc::encoder encoder (field, SCHEDULE_GEN_SIZE, SCHEDULE_SYMBOL_SIZE);
+    kodo_rlnc::decoder decoder (field, SCHEDULE_GEN_SIZE, SCHEDULE_SYMBOL_SIZE);
+    uint8_t data_in[encoder.block_size()];
+    uint8_t data_out[decoder.block_size()];
+    uint8_t symbol[SCHEDULE_SYMBOL_SIZE];
+    uint8_t coefficients[encoder.coefficient_vector_size()];
+    uint16_t tx_num = SCHEDULE_GEN_SIZE * (1 + SCHEDULE_REDUNDANCY);
+    static tx_schedule_t schedule;
+    gilbert_elliott_t channel = {burst_channel[0], burst_channel[1], false};
+    int16_t index;
+    uint16_t delivered_num;
+    uint32_t decoded_num = 0;
+    uint64_t delivered_total = 0;
+    uint64_t decode_delay = 0;      // packets until the generation is decoded
+    uint64_t delivery_delay = 0;    // packets until a symbol is delivered in order
+
+    for (uint32_t i = 0; i < sizeof data_in; i++)
+        data_in[i] = (uint8_t)rand ();
+    for (uint32_t n = 0; n < iterations; n++)
+    {
+        encoder.reset ();
+        decoder.reset ();
+        decoder.set_status_updater_on ();
+        encoder.set_symbols_storage (data_in);
+        decoder.set_symbols_storage (data_out);
+        build_tx_schedule (&schedule, type, interval, SCHEDULE_GEN_SIZE, tx_num);
+        delivered_num = 0;
+        for (uint16_t position = 0; position < tx_num && decoder.is_complete() == false; position++)
+        {
+            index = get_scheduled_symbol (&schedule, position);
+            if (index != TX_SCHEDULE_REPAIR)
+                encoder.produce_systematic_symbol (symbol, index);
+            else
+            {
+                encoder.generate (coefficients);
+                encoder.produce_symbol (symbol, coefficients);
+            }
+            if (gilbert_elliott_loss (&channel) == true)
+                continue;
+            if (index != TX_SCHEDULE_REPAIR)
+                decoder.consume_systematic_symbol (symbol, index);
+            else
+                decoder.consume_symbol (symbol, coefficients);
+            while (delivered_num < SCHEDULE_GEN_SIZE &&
+                   (decoder.is_complete() == true || decoder.is_symbol_decoded (delivered_num) == true))
+            {
+                delivery_delay += position + 1;
+                delivered_num++;
+            }
+            if (decoder.is_complete() == true)
+            {
+                decode_delay += position + 1;
+                decoded_num++;
+            }
+        }
+        delivered_total += delivered_num;
+    }
+    printf ("schedule %-11s %u burst %.2f/%.2f: decode %.3f after %5.2f packets, symbol delay %5.2f packets, delivered %.3f\n",
+            get_tx_schedule_name (type),
+            interval,
+            burst_channel[0],
+            burst_channel[1],
+            (float)decoded_num / iterations,
+            decoded_num > 0 ? (float)decode_delay / decoded_num : 0,
+            delivered_total > 0 ? (float)delivery_delay / delivered_total : 0,
+            (float)delivered_total / (iterations * SCHEDULE_GEN_SIZE));
+    fprintf (fp, "{\"type\": \"nc_bench\", \"stage\": \"schedule\", \"schedule\": \"%s\", \"interval\": %u, \"good_to_bad\": %.2f, \"bad_to_good\": %.2f, \"gen_size\": %u, \"tx_num\": %u, \"decode_prob\": %.3f, \"decode_delay\": %.2f, \"symbol_delay\": %.2f, \"delivery_ratio\": %.3f },\n",
+             get_tx_schedule_name (type),
+             interval,
+             burst_channel[0],
+             burst_channel[1],
+             SCHEDULE_GEN_SIZE,
+             tx_num,
+             (float)decoded_num / iterations,
+             decoded_num > 0 ? (float)decode_delay / decoded_num : 0,
+             delivered_total > 0 ? (float)delivery_delay / delivered_total : 0,
+             (float)delivered_total / (iterations * SCHEDULE_GEN_SIZE));
+}
+
+/**
+ * @brief compare encoding, decoding and recoding cost, linear dependence of
+ *        random coded symbols and coding vector overhead of a finite field
+ */
+void benchmark_field (FILE* fp, uint8_t field_id, uint16_t symbol_size, uint32_t iterations)
+{
+    fifi::finite_field field = (fifi::finite_field)field_id;
+    kodo_rlnc::encoder encoder (field, FIELD_GEN_SIZE, symbol_size);
+    kodo_rlnc::decoder decoder (field, FIELD_GEN_SIZE, symbol_size);
+    kodo_rlnc::pure_recoder recoder (field, FIELD_GEN_SIZE, symbol_size, FIELD_GEN_SIZE);
+    uint32_t coefficient_size = encoder.coefficient_vector_size();
+    uint8_t data_in[encoder.block_size()];
+    uint8_t data_out[decoder.block_size()];
+    // coded symbols are buffered so every stage is timed on its own
+    uint8_t* symbols = new uint8_t[FIELD_CODED_NUM * symbol_size];
+    uint8_t* coefficients = new uint8_t[FIELD_CODED_NUM * coefficient_size];
+    uint8_t symbol[symbol_size];
+    uint8_t symbol_coefficients[coefficient_size];
+    uint8_t recoding_coefficients[recoder.recoder_coefficient_vector_size()];
+    uint16_t consumed;
+    uint32_t rank;
+    uint32_t decoded_num = 0;
+    uint64_t consumed_total = 0;
+    uint64_t dependent_num = 0;
+    uint64_t start;
+    uint64_t encode_time = 0, decode_time = 0, recode_time = 0; // ns
+
+    for (uint32_t i = 0; i < sizeof data_in; i++)
+        data_in[i] = (uint8_t)rand ();
+    for (uint32_t n = 0; n < iterations; n++)
+    {
+        encoder.reset ();
+        decoder.reset ();
+        recoder.reset ();
+        // a reset encoder repeats its coefficients, dependence needs fresh ones
+        encoder.set_seed ((uint32_t)rand ());
+        encoder.set_systematic_off ();
+        encoder.set_symbols_storage (data_in);
+        decoder.set_symbols_storage (data_out);
+
+        start = get_time_ns ();
+        for (uint16_t i = 0; i < FIELD_CODED_NUM; i++)
+        {
+            encoder.generate (coefficients + i * coefficient_size);
+            encoder.produce_symbol (symbols + i * symbol_size, coefficients + i * coefficient_size);
+        }
+        encode_time += get_time_ns () - start;
+
+        // the decoder works in place, so it gets a copy of every symbol it consumes
+        start = get_time_ns ();
+        for (consumed = 0; consumed < FIELD_CODED_NUM && decoder.is_complete() == false; consumed++)
+        {
+            rank = decoder.rank ();
+            memcpy (symbol, symbols + consumed * symbol_size, symbol_size);
+            memcpy (symbol_coefficients, coefficients + consumed * coefficient_size, coefficient_size);
+            decoder.consume_symbol (symbol, symbol_coefficients);
+            if (decoder.rank () == rank)
+                dependent_num++;
+        }
+        decode_time += get_time_ns () - start;
+        consumed_total += consumed;
+        if (decoder.is_complete() == true)
+        {
+            decoded_num++;
+            if (memcmp (data_in, data_out, sizeof data_in) != 0)
+                fprintf (stderr, "field stage decoded wrong data over %s\n", get_field_name (field_id));
+        }
+
+        // a relay holding one generation of coded symbols recodes as many again
+        start = get_time_ns ();
+        for (uint16_t i = 0; i < FIELD_GEN_SIZE; i++)
+            recoder.consume_symbol (symbols + i * symbol_size, coefficients + i * coefficient_size);
+        for (uint16_t i = 0; i < FIELD_GEN_SIZE; i++)
+        {
+            recoder.recoder_generate (recoding_coefficients);
+            recoder.recoder_produce_symbol (symbol, symbol_coefficients, recoding_coefficients);
+        }
+        recode_time += get_time_ns () - start;
+    }
+    delete[] symbols;
+    delete[] coefficients;
+
+    printf ("field %-9s symbol %3u: encode %6.2f MB/s, decode %6.2f MB/s, recode %6.2f MB/s, dependent %.4f, extra %.3f packets, vector %2u bytes (%.1f%%)\n",
+            get_field_name (field_id),
+            symbol_size,
+            (double)iterations * FIELD_CODED_NUM * symbol_size * 1e3 / encode_time,
+            (double)consumed_total * symbol_size * 1e3 / decode_time,
+            (double)iterations * 2 * FIELD_GEN_SIZE * symbol_size * 1e3 / recode_time,
+            consumed_total > 0 ? (double)dependent_num / consumed_total : 0,
+            decoded_num > 0 ? (double)dependent_num / decoded_num : 0,
+            coefficient_size,
+            100.0 * coefficient_size / symbol_size);
+    fprintf (fp, "{\"type\": \"nc_bench\", \"stage\": \"field\", \"field\": \"%s\", \"symbol_size\": %u, \"gen_size\": %u, \"encode_mbps\": %.2f, \"decode_mbps\": %.2f, \"recode_mbps\": %.2f, \"dependent_prob\": %.4f, \"extra_packets\": %.3f, \"decode_prob\": %.3f, \"vector_size\": %u },\n",
+             get_field_name (field_id),
+             symbol_size,
+             FIELD_GEN_SIZE,
+             (double)iterations * FIELD_CODED_NUM * symbol_size * 1e3 / encode_time,
+             (double)consumed_total * symbol_size * 1e3 / decode_time,
+             (double)iterations * 2 * FIELD_GEN_SIZE * symbol_size * 1e3 / recode_time,
+             consumed_total > 0 ? (double)dependent_num / consumed_total : 0,
+             decoded_num > 0 ? (double)dependent_num / decoded_num : 0,
+             (float)decoded_num / iterations,
+             coefficient_size);
+}
+
+/**
+ * @brief send coded symbols until decoded, either at a fixed density or with the
+ *        rank driven tunable sparse schedule fed by a rank report every few packets,
+ *        measure decoding time against the packets needed
+ */
+void benchmark_sparse (FILE* fp, float fixed_density, float dependence, uint32_t iterations)
+{
+    fifi::finite_field field = fifi::finite_field::binary8;
+    kodo_rlnc::encoder encoder (field, SPARSE_GEN_SIZE, SPARSE_SYMBOL_SIZE);
+    kodo_rlnc::decoder decoder (field, SPARSE_GEN_SIZE, SPARSE_SYMBOL_SIZE);
+    uint8_t data_in[encoder.block_size()];
+    uint8_t data_out[decoder.block_size()];
+    uint8_t symbol[SPARSE_SYMBOL_SIZE];
+    uint8_t coefficients[encoder.coefficient_vector_size()];
+    sparse_schedule_t schedule;
+    bool scheduled = dependence > 0;
+    float density = fixed_density;
+    uint16_t reported_rank;
+    uint16_t tx_num;
+    uint32_t decoded_num = 0;
+    uint64_t tx_total = 0;
+    uint64_t nonzero_total = 0;
+    uint64_t start;
+    uint64_t decode_time = 0; // ns
+
+    init_sparse_schedule (&schedule, SPARSE_GEN_SIZE, 8, dependence);
+    for (uint32_t i = 0; i < sizeof data_in; i++)
+        data_in[i] = (uint8_t)rand ();
+    for (uint32_t n = 0; n < iterations; n++)
+    {
+        encoder.reset ();
+        decoder.reset ();
+        encoder.set_seed ((uint32_t)rand ());
+        encoder.set_systematic_off ();
+        encoder.set_symbols_storage (data_in);
+        decoder.set_symbols_storage (data_out);
+        reported_rank = 0;
+        for (tx_num = 0; tx_num < 8 * SPARSE_GEN_SIZE && decoder.is_complete() == false; tx_num++)
+        {
+            if (scheduled == true)
+            {
+                if (tx_num % SPARSE_REPORT_INTERVAL == 0)
+                    reported_rank = decoder.rank ();
+                density = get_sparse_density (&schedule,
+                                              estimate_remote_rank (SPARSE_GEN_SIZE,
+                                                                    reported_rank,
+                                                                    tx_num % SPARSE_REPORT_INTERVAL,
+                                                                    0));
+            }
+            encoder.set_density (density);
+            encoder.generate (coefficients);
+            for (uint16_t i = 0; i < sizeof coefficients; i++)
+                nonzero_total += coefficients[i] != 0;
+            encoder.produce_symbol (symbol, coefficients);
+            start = get_time_ns ();
+            decoder.consume_symbol (symbol, coefficients);
+            decode_time += get_time_ns () - start;
+        }
+        tx_total += tx_num;
+        if (decoder.is_complete() == true)
+            decoded_num++;
+    }
+    if (decoded_num < iterations || memcmp (data_in, data_out, sizeof data_in) != 0)
+        fprintf (stderr, "sparse stage failed to decode\n");
+
+    if (scheduled == true)
+        printf ("sparse schedule %.2f: ", dependence);
+    else
+        printf ("sparse fixed    %.2f: ", fixed_density);
+    printf ("decode %7.1f us per generation, %6.2f packets (overhead %5.2f%%), %5.2f non-zeros per vector\n",
+            (double)decode_time / iterations / 1000,
+            (double)tx_total / iterations,
+            100.0 * ((double)tx_total / iterations - SPARSE_GEN_SIZE) / SPARSE_GEN_SIZE,
+            (double)nonzero_total / tx_total);
+    fprintf (fp, "{\"type\": \"nc_bench\", \"stage\": \"sparse\", \"density\": \"%s\", \"fixed_density\": %.2f, \"dependence\": %.2f, \"symbol_size\": %u, \"gen_size\": %u, \"decode_us\": %.1f, \"tx_num\": %.2f, \"overhead\": %.4f, \"nonzero_num\": %.2f },\n",
+             scheduled == true ? "scheduled" : "fixed",
+             scheduled == true ? 0 : fixed_density,
+             dependence,
+             SPARSE_SYMBOL_SIZE,
+             SPARSE_GEN_SIZE,
+             (double)decode_time / iterations / 1000,
+             (double)tx_total / iterations,
+             ((double)tx_total / iterations - SPARSE_GEN_SIZE) / SPARSE_GEN_SIZE,
+             (double)nonzero_total / tx_total);
+}
+
+/**
+ * @brief relay a generation over two lossy hops through a pure recoder storing
+ *        depth coded symbols, measure the second hop packets the destination
+ *        needs against the relay memory
+ */
+void benchmark_recoder_depth (FILE* fp, uint16_t depth, uint32_t iterations)
+{
+    fifi::finite_field field = fifi::finite_field::binary8;
+    kodo_rlnc::encoder encoder (field, DEPTH_GEN_SIZE, DEPTH_SYMBOL_SIZE);
+    kodo_rlnc::pure_recoder recoder (field, DEPTH_GEN_SIZE, DEPTH_SYMBOL_SIZE, depth);
+    kodo_rlnc::decoder decoder (field, DEPTH_GEN_SIZE, DEPTH_SYMBOL_SIZE);
+    rank_tracker_t tracker;
+    uint8_t data_in[encoder.block_size()];
+    uint8_t data_out[decoder.block_size()];
+    uint8_t symbol[DEPTH_SYMBOL_SIZE];
+    uint8_t coefficients[encoder.coefficient_vector_size()];
+    uint8_t recoding_coefficients[recoder.recoder_coefficient_vector_size()];
+    uint32_t memory = get_recoder_memory (NC_FIELD_BINARY8, DEPTH_GEN_SIZE, DEPTH_SYMBOL_SIZE, depth);
+    uint32_t rank;
+    uint16_t relay_tx_num;
+    uint32_t decoded_num = 0;
+    uint64_t relay_tx_total = 0;
+    uint64_t dependent_num = 0;
+    uint64_t start;
+    uint64_t recode_time = 0; // ns
+
+    init_rank_tracker (&tracker, field, DEPTH_GEN_SIZE);
+    for (uint32_t i = 0; i < sizeof data_in; i++)
+        data_in[i] = (uint8_t)rand ();
+    for (uint32_t n = 0; n < iterations; n++)
+    {
+        encoder.reset ();
+        recoder.reset ();
+        decoder.reset ();
+        reset_rank_tracker (&tracker);
+        encoder.set_seed ((uint32_t)rand ());
+        encoder.set_systematic_off ();
+        encoder.set_symbols_storage (data_in);
+        decoder.set_symbols_storage (data_out);
+        relay_tx_num = 0;
+        // the relay forwards a recoded packet per innovative arrival until it has the
+        // whole generation, then repair packets until the destination decodes
+        while (decoder.is_complete() == false && relay_tx_num < 8 * DEPTH_GEN_SIZE)
+        {
+            if (get_tracked_rank (&tracker) < DEPTH_GEN_SIZE)
+            {
+                encoder.generate (coefficients);
+                encoder.produce_symbol (symbol, coefficients);
+                if ((float)rand () / RAND_MAX < DEPTH_FIRST_LOSS ||
+                    track_coded_symbol (&tracker, coefficients) == false)
+                    continue;
+                recoder.consume_symbol (symbol, coefficients);
+            }
+            start = get_time_ns ();
+            recoder.recoder_generate (recoding_coefficients);
+            recoder.recoder_produce_symbol (symbol, coefficients, recoding_coefficients);
+            recode_time += get_time_ns () - start;
+            relay_tx_num++;
+            if ((float)rand () / RAND_MAX < DEPTH_SECOND_LOSS)
+                continue;
+            rank = decoder.rank ();
+            decoder.consume_symbol (symbol, coefficients);
+            if (decoder.rank () == rank)
+                dependent_num++;
+        }
+        relay_tx_total += relay_tx_num;
+        if (decoder.is_complete() == true)
+        {
+            decoded_num++;
+            if (memcmp (data_in, data_out, sizeof data_in) != 0)
+                fprintf (stderr, "recoder depth stage decoded wrong data\n");
+        }
+    }
+    free_rank_tracker (&tracker);
+
+    printf ("recoder depth %2u: relay memory %6u bytes, %6.2f second hop packets (overhead %6.2f%%), %5.2f dependent, recode %5.0f ns per symbol, decoded %.3f\n",
+            depth,
+            memory,
+            (double)relay_tx_total / iterations,
+            100.0 * ((double)relay_tx_total / iterations * (1 - DEPTH_SECOND_LOSS) - DEPTH_GEN_SIZE) / DEPTH_GEN_SIZE,
+            (double)dependent_num / iterations,
+            (double)recode_time / relay_tx_total,
+            (float)decoded_num / iterations);
+    fprintf (fp, "{\"type\": \"nc_bench\", \"stage\": \"recoder_depth\", \"depth\": %u, \"symbol_size\": %u, \"gen_size\": %u, \"first_loss\": %.2f, \"second_loss\": %.2f, \"relay_memory\": %u, \"relay_tx_num\": %.2f, \"overhead\": %.4f, \"dependent_num\": %.2f, \"recode_ns\": %.0f, \"decode_prob\": %.3f },\n",
+             depth,
+             DEPTH_SYMBOL_SIZE,
+             DEPTH_GEN_SIZE,
+             DEPTH_FIRST_LOSS,
+             DEPTH_SECOND_LOSS,
+             memory,
+             (double)relay_tx_total / iterations,
+             ((double)relay_tx_total / iterations * (1 - DEPTH_SECOND_LOSS) - DEPTH_GEN_SIZE) / DEPTH_GEN_SIZE,
+             (double)dependent_num / iterations,
+             (double)recode_time / relay_tx_total,
+             (float)decoded_num / iterations);
+}
+
+/**
+ * @brief relay a systematic generation over two lossy hops, slot by slot, either
+ *        recoding (one recoded packet per innovative arrival, then repair) or decoding
+ *        and forwarding (each source symbol once decoded, then fresh repair symbols),
+ *        every hop is fed until the next one has what it needs, measure the packets
+ *        on both hops, the relay coding time and the delay of every source symbol
+ */
+void benchmark_relay_mode (FILE* fp, bool decode_forward, float second_loss, uint32_t iterations)
+{
+    fifi::finite_field field = fifi::finite_field::binary8;
+    kodo_rlnc::encoder encoder (field, RELAY_GEN_SIZE, RELAY_SYMBOL_SIZE);
+    kodo_rlnc::pure_recoder recoder (field, RELAY_GEN_SIZE, RELAY_SYMBOL_SIZE, RELAY_GEN_SIZE);
+    kodo_rlnc::decoder relay_decoder (field, RELAY_GEN_SIZE, RELAY_SYMBOL_SIZE);
+    kodo_rlnc::encoder relay_encoder (field, RELAY_GEN_SIZE, RELAY_SYMBOL_SIZE);
+    kodo_rlnc::decoder decoder (field, RELAY_GEN_SIZE, RELAY_SYMBOL_SIZE);
+    rank_tracker_t tracker;
+    uint8_t data_in[encoder.block_size()];
+    uint8_t relay_data[relay_decoder.block_size()];
+    uint8_t data_out[decoder.block_size()];
+    uint8_t symbol[RELAY_SYMBOL_SIZE];
+    uint8_t coefficients[encoder.coefficient_vector_size()];
+    uint8_t recoding_coefficients[recoder.recoder_coefficient_vector_size()];
+    bool forwarded[RELAY_GEN_SIZE];
+    bool delivered[RELAY_GEN_SIZE];
+    bool received;
+    bool innovative;
+    bool relay_send;
+    uint32_t relay_rank;
+    uint32_t source_index;
+    uint32_t slot;
+    uint32_t decoded_num = 0;
+    uint64_t first_tx_total = 0;
+    uint64_t second_tx_total = 0;
+    uint64_t decode_slot_total = 0;
+    uint64_t symbol_delay_total = 0;
+    uint64_t start;
+    uint64_t relay_time = 0; // ns
+
+    init_rank_tracker (&tracker, field, RELAY_GEN_SIZE);
+    for (uint32_t i = 0; i < sizeof data_in; i++)
+        data_in[i] = (uint8_t)rand ();
+    for (uint32_t n = 0; n < iterations; n++)
+    {
+        encoder.reset ();
+        recoder.reset ();
+        relay_decoder.reset ();
+        relay_encoder.reset ();
+        decoder.reset ();
+        reset_rank_tracker (&tracker);
+        encoder.set_seed ((uint32_t)rand ());
+        relay_encoder.set_seed ((uint32_t)rand ());
+        encoder.set_symbols_storage (data_in);
+        relay_decoder.set_symbols_storage (relay_data);
+        relay_decoder.set_status_updater_on ();
+        decoder.set_symbols_storage (data_out);
+        decoder.set_status_updater_on ();
+        memset (forwarded, 0, sizeof forwarded);
+        memset (delivered, 0, sizeof delivered);
+        source_index = 0;
+        for (slot = 1; decoder.is_complete() == false && slot <= 8 * RELAY_GEN_SIZE; slot++)
+        {
+            // first hop, the source sends until the relay holds the generation
+            received = false;
+            innovative = false;
+            relay_rank = decode_forward == true ? relay_decoder.rank () : get_tracked_rank (&tracker);
+            if (relay_rank < RELAY_GEN_SIZE)
+            {
+                if (source_index < RELAY_GEN_SIZE)
+                {
+                    encoder.produce_systematic_symbol (symbol, source_index);
+                    memset (coefficients, 0, sizeof coefficients);
+                    coefficients[source_index] = 1;
+                    source_index++;
+                }
+                else
+                {
+                    encoder.generate (coefficients);
+                    encoder.produce_symbol (symbol, coefficients);
+                }
+                first_tx_total++;
+                received = (float)rand () / RAND_MAX >= RELAY_FIRST_LOSS;
+            }
+            start = get_time_ns ();
+            if (received == true && decode_forward == true)
+            {
+                relay_decoder.consume_symbol (symbol, coefficients);
+                innovative = relay_decoder.rank () > relay_rank;
+            }
+            else if (received == true)
+            {
+                innovative = track_coded_symbol (&tracker, coefficients);
+                if (innovative == true)
+                    recoder.consume_symbol (symbol, coefficients);
+            }
+
+            // second hop, at most one packet per slot
+            relay_send = false;
+            if (decode_forward == true)
+            {
+                // the next decoded source symbol not forwarded yet, then repair
+                for (uint32_t i = 0; i < RELAY_GEN_SIZE && relay_send == false; i++)
+                {
+                    if (forwarded[i] == true || relay_decoder.is_symbol_decoded (i) == false)
+                        continue;
+                    memcpy (symbol, relay_data + i * RELAY_SYMBOL_SIZE, RELAY_SYMBOL_SIZE);
+                    memset (coefficients, 0, sizeof coefficients);
+                    coefficients[i] = 1;
+                    forwarded[i] = true;
+                    relay_send = true;
+                }
+                if (relay_send == false && relay_decoder.is_complete() == true)
+                {
+                    if (relay_encoder.rank () == 0)
+                    {
+                        relay_encoder.set_systematic_off ();
+                        relay_encoder.set_symbols_storage (relay_data);
+                    }
+                    relay_encoder.generate (coefficients);
+                    relay_encoder.produce_symbol (symbol, coefficients);
+                    relay_send = true;
+                }
+            }
+            else if (innovative == true || get_tracked_rank (&tracker) == RELAY_GEN_SIZE)
+            {
+                recoder.recoder_generate (recoding_coefficients);
+                recoder.recoder_produce_symbol (symbol, coefficients, recoding_coefficients);
+                relay_send = true;
+            }
+            relay_time += get_time_ns () - start;
+            if (relay_send == false)
+                continue;
+            second_tx_total++;
+            if ((float)rand () / RAND_MAX < second_loss)
+                continue;
+            decoder.consume_symbol (symbol, coefficients);
+            for (uint32_t i = 0; i < RELAY_GEN_SIZE; i++)
+            {
+                if (delivered[i] == true || decoder.is_symbol_decoded (i) == false)
+                    continue;
+                delivered[i] = true;
+                symbol_delay_total += slot;
+            }
+        }
+        if (decoder.is_complete() == true)
+        {
+            decoded_num++;
+            decode_slot_total += slot - 1;
+            if (memcmp (data_in, data_out, sizeof data_in) != 0)
+                fprintf (stderr, "relay mode stage decoded wrong data\n");
+        }
+    }
+    free_rank_tracker (&tracker);
+
+    printf ("relay %-7s second loss %.2f: %6.2f + %6.2f packets, relay %6.1f us per generation, decoded after %6.2f slots, symbol delay %6.2f slots, decoded %.3f\n",
+            decode_forward == true ? "decode" : "recode",
+            second_loss,
+            (double)first_tx_total / iterations,
+            (double)second_tx_total / iterations,
+            (double)relay_time / iterations / 1000,
+            decoded_num > 0 ? (double)decode_slot_total / decoded_num : 0,
+            decoded_num > 0 ? (double)symbol_delay_total / decoded_num / RELAY_GEN_SIZE : 0,
+            (float)decoded_num / iterations);
+    fprintf (fp, "{\"type\": \"nc_bench\", \"stage\": \"relay_mode\", \"mode\": \"%s\", \"symbol_size\": %u, \"gen_size\": %u, \"first_loss\": %.2f, \"second_loss\": %.2f, \"first_tx_num\": %.2f, \"second_tx_num\": %.2f, \"relay_us\": %.1f, \"decode_delay\": %.2f, \"symbol_delay\": %.2f, \"decode_prob\": %.3f },\n",
+             decode_forward == true ? "decode" : "recode",
+             RELAY_SYMBOL_SIZE,
+             RELAY_GEN_SIZE,
+             RELAY_FIRST_LOSS,
+             second_loss,
+             (double)first_tx_total / iterations,
+             (double)second_tx_total / iterations,
+             (double)relay_time / iterations / 1000,
+             decoded_num > 0 ? (double)decode_slot_total / decoded_num : 0,
+             decoded_num > 0 ? (double)symbol_delay_total / decoded_num / RELAY_GEN_SIZE : 0,
+             (float)decoded_num / iterations);
+}
+
+int main(int argc, char *argv[])
+{
+    char* log_file_name = (char*)LOG_FILE;
+    uint32_t iterations = 200;
+
+    // cmd arguments parsing
+    int opt;
+    int option_index = 0;
+
+    while ((opt = getopt_long (argc, argv, "n:l:h", long_options, &option_index)) != -1)
+    {
+        switch (opt)
+        {
+            case 'n':
+                iterations = atoi (optarg);
+                break;
+            case 'l':
+                log_file_name = optarg;
+                break;
+            case 'h':
+                usage ();
+                return 0;
+            default:
+                usage ();
+                return 0;
+        }
+    }
+
+    // fixed seed for reproducible source data
+    srand (1);
+
+    FILE* fp = fopen (log_file_name, "a+");
+    if (fp == NULL)
+    {
+        fprintf (stderr, "error %d opening %s: %s\n", errno, log_file_name, strerror (errno));
+        return -1;
+    }
+
+    for (uint8_t s = 0; s < sizeof symbol_sizes / sizeof symbol_sizes[0]; s++)
+        for (uint8_t g = 0; g < sizeof generation_sizes / sizeof generation_sizes[0]; g++)
+        {
+            benchmark_symbol (fp, symbol_sizes[s], generation_sizes[g], iterations);
+            benchmark_batch (fp, symbol_sizes[s], generation_sizes[g], iterations);
+        }
+    for (uint8_t c = 0; c < sizeof burst_channels / sizeof burst_channels[0]; c++)
+        for (uint8_t k = 0; k < sizeof schedules / sizeof schedules[0]; k++)
+            benchmark_schedule (fp, schedules[k][0], schedules[k][1], burst_channels[c], 20 * iterations);
+    for (uint8_t f = 0; f < NC_FIELD_NUM; f++)
+        for (uint8_t s = 0; s < sizeof field_symbol_sizes / sizeof field_symbol_sizes[0]; s++)
+            benchmark_field (fp, f, field_symbol_sizes[s], iterations);
+    for (uint8_t d = 0; d < sizeof fixed_densities / sizeof fixed_densities[0]; d++)
+        benchmark_sparse (fp, fixed_densities[d], 0, iterations);
+    for (uint8_t d = 0; d < sizeof schedule_dependences / sizeof schedule_dependences[0]; d++)
+        benchmark_sparse (fp, 0, schedule_dependences[d], iterations);
+    for (uint8_t d = 0; d < sizeof recoder_depths / sizeof recoder_depths[0]; d++)
+        benchmark_recoder_depth (fp, recoder_depths[d], iterations);
+    for (uint8_t l = 0; l < sizeof second_hop_losses / sizeof second_hop_losses[0]; l++)
+    {
+        benchmark_relay_mode (fp, false, second_hop_losses[l], iterations);
+        benchmark_relay_mode (fp, true, second_hop_losses[l], iterations);
+    }
+    fclose (fp);
+    return 0;
+}
@@ -0,0 +1,87 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "autotune.h"
+#include "redundancy.h"
+#include "nc_header.h"
+#include "coding_vector.h"
+#include "lowpan.h"
+
+/*
+   Every packet of a generation must fit in MAX_MSDU_SIZE, otherwise it is
+   fragmented and needs two or more frames. The symbol size follows from
+   the generation size: what is left of a frame after the compressed
+   IP/UDP headers, the NC header and the coding header of the largest
+   packet type. Among all generation sizes the tuner takes the one that
+   delivers the most source bytes per frame, sending per generation the
+   fewest packets that reach the target decode probability.
+*/
+
+/**
+ * @brief get the coding header of the largest packet type of a generation
+ */
+static uint16_t get_coding_header_size (const autotune_input_t* input, uint16_t generation_size)
+{
+    uint16_t size = NC_INDEX_SIZE;
+    uint16_t vector_size = SEED_HDR_SIZE;
+    if (input->vector_format == AUTOTUNE_FULL_VECTOR)
+        vector_size = (generation_size * input->field_bits + 7) / 8;
+    if (vector_size > size)
+        size = vector_size;
+    return size;
+}
+
+uint16_t get_fitting_symbol_size (const autotune_input_t* input, uint16_t generation_size)
+{
+    uint16_t header_size = IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE + NC_HDR_SIZE +
+                           input->extra_header_size +
+                           get_coding_header_size (input, generation_size);
+    if (header_size >= MAX_MSDU_SIZE)
+        return 0;
+    return MAX_MSDU_SIZE - header_size;
+}
+
+bool autotune_coding (const autotune_input_t* input, autotune_result_t* result)
+{
+    autotune_result_t candidate;
+    uint32_t generation_num;
+    uint32_t block_size;
+    bool found = false;
+
+    memset (result, 0, sizeof (autotune_result_t));
+    for (uint16_t g = 1; g <= input->max_generation_size && g <= AUTOTUNE_MAX_GEN_SIZE; g++)
+    {
+        memset (&candidate, 0, sizeof candidate);
+        candidate.generation_size = g;
+        candidate.symbol_size = get_fitting_symbol_size (input, g);
+        if (candidate.symbol_size == 0)
+            break;
+        // fewest packets per generation that reach the target
+        for (candidate.tx_num = g; candidate.tx_num < 4 * g; candidate.tx_num++)
+        {
+            candidate.decode_probability = get_decode_probability (g, candidate.tx_num, input->loss, input->field_bits);
+            if (candidate.decode_probability >= input->target)
+                break;
+        }
+        if (candidate.decode_probability < input->target)
+            continue;
+        candidate.redundancy = (100 * (candidate.tx_num - g) + g - 1) / g;
+        candidate.packet_size = MAX_MSDU_SIZE;
+        // a payload that does not fill its last generation wastes the rest of it
+        block_size = (uint32_t)g * candidate.symbol_size;
+        generation_num = 1;
+        if (input->payload_size > 0)
+            generation_num = (input->payload_size + block_size - 1) / block_size;
+        candidate.frame_num = generation_num * candidate.tx_num;
+        candidate.goodput = (input->payload_size > 0 ? input->payload_size : block_size) *
+                            candidate.decode_probability / candidate.frame_num;
+        // ties go to the smaller generation, it decodes sooner and cheaper
+        if (found == false || candidate.goodput > result->goodput)
+        {
+            *result = candidate;
+            found = true;
+        }
+    }
+    return found;
+}
@@ -0,0 +1,78 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "coding_vector.h"
+#include "nc_field.h"
+
+/*
+   seed encoded coding vector
+   +------+---------+
+   | seed | density |
+   +------+---------+
+    2 B       1 B
+   Client, relay and server expand the seed with the same generator, so
+   the coding vector never has to be sent. Density is quantized to 1/255;
+   255 gives a dense vector. The expanded vector is packed for the field
+   of the generation, so the seed header itself is field independent.
+*/
+
+/**
+ * @brief xorshift32 step
+ */
+static uint32_t next_random (uint32_t* state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+void set_seed_header (uint8_t* seed_offset, uint16_t seed, float density)
+{
+    if (density > 1)
+        density = 1;
+    *seed_offset = (uint8_t)(seed >> 8);
+    *(seed_offset + 1) = (uint8_t)seed;
+    *(seed_offset + 2) = (uint8_t)(density * SEED_DENSITY_SCALE + 0.5);
+}
+
+uint16_t get_seed (uint8_t* seed_offset)
+{
+    return (uint16_t)(*seed_offset << 8) | *(seed_offset + 1);
+}
+
+float get_seed_density (uint8_t* seed_offset)
+{
+    return (float)*(seed_offset + 2) / SEED_DENSITY_SCALE;
+}
+
+void generate_seeded_coefficients (uint8_t* coefficients,
+                                   uint32_t symbols,
+                                   uint16_t seed,
+                                   float density,
+                                   uint8_t field)
+{
+    // xorshift must not start from zero
+    uint32_t state = 0x9e3779b9 ^ seed;
+    uint32_t threshold = (uint32_t)(density * SEED_DENSITY_SCALE + 0.5);
+    bool empty = true;
+    uint32_t index;
+
+    memset (coefficients, 0, get_field_vector_size (field, symbols));
+    for (uint32_t i = 0; i < symbols; i++)
+    {
+        if (next_random (&state) % SEED_DENSITY_SCALE >= threshold)
+            continue;
+        set_field_value (coefficients, field, i, get_nonzero_field_value (field, next_random (&state)));
+        empty = false;
+    }
+    // a coding vector always covers at least one symbol
+    if (empty == true)
+    {
+        index = next_random (&state) % symbols;
+        set_field_value (coefficients, field, index, get_nonzero_field_value (field, next_random (&state)));
+    }
+}
@@ -0,0 +1,66 @@
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "delivery.h"
+
+/*
+   The sink gets raw source bytes in delivery order, without framing, so a
+   file sink ends up holding the transferred data and a pipe sink can be
+   read by any program. Symbols are delivered as soon as they and all
+   earlier symbols of their generation are decoded.
+*/
+
+int open_delivery_sink (delivery_sink_t* sink, const char* path)
+{
+    memset (sink, 0, sizeof (delivery_sink_t));
+    if (path == NULL)
+        return 0;
+    // a named pipe blocks here until a reader opens it
+    sink->fp = fopen (path, "wb");
+    if (sink->fp == NULL)
+    {
+        fprintf (stderr, "error %d opening %s: %s\n", errno, path, strerror (errno));
+        return -1;
+    }
+    return 0;
+}
+
+void set_delivery_callback (delivery_sink_t* sink, delivery_callback_t callback, void* context)
+{
+    sink->callback = callback;
+    sink->context = context;
+}
+
+bool is_delivery_sink_open (delivery_sink_t* sink)
+{
+    return sink->fp != NULL || sink->callback != NULL;
+}
+
+int deliver_symbol (delivery_sink_t* sink,
+                    uint8_t generation_id,
+                    uint16_t index,
+                    const uint8_t* symbol,
+                    uint16_t length)
+{
+    if (sink->fp != NULL)
+    {
+        if (fwrite (symbol, 1, length, sink->fp) != length)
+            return -1;
+        // readers of a pipe see the symbol right away
+        fflush (sink->fp);
+    }
+    if (sink->callback != NULL)
+        sink->callback (generation_id, index, symbol, length, sink->context);
+    sink->symbol_num++;
+    sink->byte_num += length;
+    return 0;
+}
+
+void close_delivery_sink (delivery_sink_t* sink)
+{
+    if (sink->fp != NULL)
+        fclose (sink->fp);
+    sink->fp = NULL;
+}
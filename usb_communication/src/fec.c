@@ -0,0 +1,290 @@
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "lowpan.h"
+#include "fec.h"
+#include "gf256.h"
+
+/*
+   FEC fragment structure
+   +-------+---------------+-----+-------+---+---+---------+
+   | 11010 | datagram size | tag | index | k | r | payload |
+   +-------+---------------+-----+-------+---+---+---------+
+     5 bits     11 bits     2 B     1 B   1 B 1 B
+
+   A datagram is split into k equally sized data fragments (the last one
+   is zero padded) followed by r parity fragments. Parity fragment j is
+   the combination of the data fragments with the Cauchy coefficients
+   1 / ((k + j) ^ i), so any k out of the k + r fragments rebuild the
+   datagram.
+*/
+
+// variable definitions
+static fec_reassembler_t m_fec_reassembler;
+static uint8_t m_fec_packet_buffer[MAX_MSDU_SIZE];
+static uint16_t m_last_complete_tag = 0;
+static bool m_last_complete_valid = false;
+
+/**
+ * @brief get datagram size in FEC fragment header
+ */
+static uint16_t get_fec_datagram_size (uint8_t* frame)
+{
+    return (uint16_t)((*frame & ~k_fec_frag_dispatch_mask) << 8) | *(frame + 1);
+}
+
+/**
+ * @brief get coefficient of data fragment i in the generator row of fragment index
+ */
+static uint8_t get_fec_coefficient (uint8_t index, uint8_t i, uint8_t data_num)
+{
+    if (index < data_num) // systematic fragment
+        return index == i ? 1 : 0;
+    return gf256_inv ((uint8_t)(index ^ i));
+}
+
+/**
+ * @brief rebuild the data fragments from k received fragments
+ */
+static void fec_decode (void)
+{
+    uint8_t k = m_fec_reassembler.data_num;
+    uint8_t size = m_fec_reassembler.fragment_size;
+    uint8_t matrix[FEC_MAX_DATA_FRAG_NUM][FEC_MAX_DATA_FRAG_NUM];
+    uint8_t* symbols[FEC_MAX_DATA_FRAG_NUM];
+    uint8_t selected = 0;
+    uint8_t* tmp_symbol;
+    uint8_t tmp_row[FEC_MAX_DATA_FRAG_NUM];
+    uint8_t factor;
+
+    // pick the first k received fragments
+    for (uint8_t index = 0; index < k + m_fec_reassembler.parity_num && selected < k; index++)
+    {
+        if (m_fec_reassembler.received[index] == false)
+            continue;
+        for (uint8_t i = 0; i < k; i++)
+            matrix[selected][i] = get_fec_coefficient (index, i, k);
+        symbols[selected] = m_fec_reassembler.fragments[index];
+        selected++;
+    }
+
+    // Gauss-Jordan elimination on the selected rows
+    for (uint8_t col = 0; col < k; col++)
+    {
+        uint8_t pivot = col;
+        while (matrix[pivot][col] == 0)
+            pivot++;
+        if (pivot != col)
+        {
+            memcpy (tmp_row, matrix[pivot], k);
+            memcpy (matrix[pivot], matrix[col], k);
+            memcpy (matrix[col], tmp_row, k);
+            tmp_symbol = symbols[pivot];
+            symbols[pivot] = symbols[col];
+            symbols[col] = tmp_symbol;
+        }
+        factor = gf256_inv (matrix[col][col]);
+        gf256_mul_region (matrix[col], factor, k);
+        gf256_mul_region (symbols[col], factor, size);
+        for (uint8_t row = 0; row < k; row++)
+        {
+            factor = matrix[row][col];
+            if (row == col || factor == 0)
+                continue;
+            gf256_mul_add_region (matrix[row], matrix[col], factor, k);
+            gf256_mul_add_region (symbols[row], symbols[col], factor, size);
+        }
+    }
+
+    // row i now holds data fragment i
+    for (uint8_t i = 0; i < k; i++)
+        m_fec_reassembler.rows[i] = (uint8_t)((symbols[i] - m_fec_reassembler.fragments[0]) /
+                                              FEC_FRAG_DATA_SIZE);
+}
+
+/**
+ * @brief check if a frame is a FEC fragment
+ */
+bool is_fec_fragment (uint8_t* frame)
+{
+    return (*frame & k_fec_frag_dispatch_mask) == k_fec_frag_type_mask;
+}
+
+/**
+ * @brief calculate number of data fragments for a datagram
+ */
+uint8_t calculate_fec_data_num (uint16_t datagram_size)
+{
+    return (datagram_size + FEC_FRAG_DATA_SIZE - 1) / FEC_FRAG_DATA_SIZE;
+}
+
+/**
+ * @brief calculate payload size of every fragment for a datagram
+ */
+uint8_t calculate_fec_fragment_size (uint16_t datagram_size)
+{
+    uint8_t data_num = calculate_fec_data_num (datagram_size);
+    return (datagram_size + data_num - 1) / data_num;
+}
+
+/**
+ * @brief calculate length of a FEC fragment from its header
+ */
+uint8_t calculate_fec_frame_length (uint8_t* frame)
+{
+    return FEC_FRAG_HDR_SIZE + calculate_fec_fragment_size (get_fec_datagram_size (frame));
+}
+
+/**
+ * @brief fragment a datagram into k data and r parity fragments, return k + r
+ */
+uint8_t do_fec_fragmentation (virtual_packet_t tx_packet[],
+                              uint8_t* payload,
+                              uint16_t length,
+                              uint8_t parity_num)
+{
+    uint8_t data_num = calculate_fec_data_num (length);
+    uint8_t fragment_size = calculate_fec_fragment_size (length);
+    uint16_t datagram_tag = (uint16_t)rand();
+    uint16_t offset = 0;
+    uint8_t copy_size = 0;
+
+    gf256_init ();
+    if (parity_num > FEC_MAX_PARITY_NUM)
+        parity_num = FEC_MAX_PARITY_NUM;
+
+    for (uint8_t index = 0; index < data_num + parity_num; index++)
+    {
+        memset (m_fec_packet_buffer, 0, sizeof m_fec_packet_buffer);
+        // set fragment header
+        *m_fec_packet_buffer = k_fec_frag_type_mask | (uint8_t)(length >> 8);
+        *(m_fec_packet_buffer + 1) = (uint8_t)length;
+        *(uint16_t*)(m_fec_packet_buffer + 2) = datagram_tag;
+        *(m_fec_packet_buffer + 4) = index;
+        *(m_fec_packet_buffer + 5) = data_num;
+        *(m_fec_packet_buffer + 6) = parity_num;
+        if (index < data_num) // data fragment, tail is zero padded
+        {
+            offset = index * fragment_size;
+            copy_size = length - offset < fragment_size ? length - offset : fragment_size;
+            memcpy (m_fec_packet_buffer + FEC_FRAG_DATA_OFFSET, payload + offset, copy_size);
+        }
+        else // parity fragment
+        {
+            for (uint8_t i = 0; i < data_num; i++)
+            {
+                offset = i * fragment_size;
+                copy_size = length - offset < fragment_size ? length - offset : fragment_size;
+                gf256_mul_add_region (m_fec_packet_buffer + FEC_FRAG_DATA_OFFSET,
+                                      payload + offset,
+                                      get_fec_coefficient (index, i, data_num),
+                                      copy_size);
+            }
+        }
+        virtual_send (&tx_packet[index],
+                      m_fec_packet_buffer,
+                      FEC_FRAG_HDR_SIZE + fragment_size);
+    }
+    return data_num + parity_num;
+}
+
+/**
+ * @brief initialize FEC reassembler
+ */
+void init_fec_reassembler (void)
+{
+    memset (&m_fec_reassembler, 0, sizeof m_fec_reassembler);
+    m_fec_reassembler.idle = true;
+}
+
+/**
+ * @brief check if FEC reassembler is running
+ */
+bool is_fec_reassembler_running (void)
+{
+    return !m_fec_reassembler.idle && !m_fec_reassembler.complete;
+}
+
+/**
+ * @brief feed a FEC fragment into the reassembler, return false if it is not accepted
+ */
+bool read_fec_fragment (uint8_t* frame, uint16_t length)
+{
+    uint16_t datagram_tag = get_datagram_tag (frame + 2);
+    uint16_t datagram_size = get_fec_datagram_size (frame);
+    uint8_t index = *(frame + 4);
+    uint8_t data_num = *(frame + 5);
+    uint8_t parity_num = *(frame + 6);
+
+    // check header consistency
+    if (datagram_size > MAX_PACKET_SIZE ||
+        data_num != calculate_fec_data_num (datagram_size) ||
+        parity_num > FEC_MAX_PARITY_NUM ||
+        index >= data_num + parity_num ||
+        length != FEC_FRAG_HDR_SIZE + calculate_fec_fragment_size (datagram_size))
+        return false;
+    // trailing fragments of an already rebuilt datagram
+    if (m_last_complete_valid == true && datagram_tag == m_last_complete_tag)
+        return false;
+    // start a new datagram
+    if (m_fec_reassembler.idle == true || m_fec_reassembler.datagram_tag != datagram_tag)
+    {
+        gf256_init ();
+        init_fec_reassembler ();
+        m_fec_reassembler.idle = false;
+        m_fec_reassembler.datagram_tag = datagram_tag;
+        m_fec_reassembler.datagram_size = datagram_size;
+        m_fec_reassembler.fragment_size = calculate_fec_fragment_size (datagram_size);
+        m_fec_reassembler.data_num = data_num;
+        m_fec_reassembler.parity_num = parity_num;
+    }
+    // duplicate fragment
+    if (m_fec_reassembler.received[index] == true || m_fec_reassembler.complete == true)
+        return false;
+
+    memcpy (m_fec_reassembler.fragments[index],
+            frame + FEC_FRAG_DATA_OFFSET,
+            m_fec_reassembler.fragment_size);
+    m_fec_reassembler.received[index] = true;
+    m_fec_reassembler.received_num++;
+
+    // any k fragments rebuild the datagram
+    if (m_fec_reassembler.received_num == data_num)
+    {
+        fec_decode ();
+        m_fec_reassembler.complete = true;
+        m_last_complete_tag = datagram_tag;
+        m_last_complete_valid = true;
+    }
+    return true;
+}
+
+/**
+ * @brief check if a datagram is rebuilt from the received fragments
+ */
+bool is_fec_reassemble_complete (void)
+{
+    return m_fec_reassembler.complete;
+}
+
+/**
+ * @brief extract a rebuilt datagram to another buffer, return datagram size
+ */
+uint16_t extract_fec_packet (uint8_t* extract_buffer)
+{
+    uint16_t offset = 0;
+    uint8_t copy_size = 0;
+    for (uint8_t i = 0; i < m_fec_reassembler.data_num; i++)
+    {
+        offset = i * m_fec_reassembler.fragment_size;
+        copy_size = m_fec_reassembler.datagram_size - offset < m_fec_reassembler.fragment_size ?
+                    m_fec_reassembler.datagram_size - offset : m_fec_reassembler.fragment_size;
+        memcpy (extract_buffer + offset,
+                m_fec_reassembler.fragments[m_fec_reassembler.rows[i]],
+                copy_size);
+    }
+    return m_fec_reassembler.datagram_size;
+}
@@ -0,0 +1,157 @@
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "file_map.h"
+
+/*
+   Files are mapped so coders can use the file contents as their symbol
+   storage directly. stdin can not be mapped, it is read into a growing
+   heap buffer instead.
+*/
+
+#define STDIN_CHUNK_SIZE    65536
+
+/**
+ * @brief read stdin until end of file into a heap buffer
+ */
+static int read_stdin (file_map_t* map)
+{
+    uint64_t capacity = 0;
+    ssize_t rx_num;
+    uint8_t* data;
+
+    do
+    {
+        if (map->size + STDIN_CHUNK_SIZE > capacity)
+        {
+            capacity = 2 * capacity + STDIN_CHUNK_SIZE;
+            data = (uint8_t*)realloc (map->data, capacity);
+            if (data == NULL)
+            {
+                fprintf (stderr, "error reading stdin: out of memory\n");
+                return -1;
+            }
+            map->data = data;
+        }
+        rx_num = read (STDIN_FILENO, map->data + map->size, STDIN_CHUNK_SIZE);
+        if (rx_num < 0 && errno != EINTR)
+        {
+            fprintf (stderr, "error %d reading stdin: %s\n", errno, strerror (errno));
+            return -1;
+        }
+        if (rx_num > 0)
+            map->size += rx_num;
+    } while (rx_num != 0);
+    return 0;
+}
+
+int map_input_file (file_map_t* map, const char* path)
+{
+    struct stat st;
+    int fd;
+
+    memset (map, 0, sizeof (file_map_t));
+    if (strcmp (path, "-") == 0)
+        return read_stdin (map);
+    fd = open (path, O_RDONLY);
+    if (fd < 0 || fstat (fd, &st) < 0)
+    {
+        fprintf (stderr, "error %d opening %s: %s\n", errno, path, strerror (errno));
+        if (fd >= 0)
+            close (fd);
+        return -1;
+    }
+    map->size = st.st_size;
+    // an empty file can not be mapped, there is nothing to send either
+    if (map->size > 0)
+    {
+        map->data = (uint8_t*)mmap (NULL, map->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map->data == MAP_FAILED)
+        {
+            fprintf (stderr, "error %d mapping %s: %s\n", errno, path, strerror (errno));
+            map->data = NULL;
+            close (fd);
+            return -1;
+        }
+        map->mapped = true;
+        // pages are read once in order
+        madvise (map->data, map->size, MADV_SEQUENTIAL);
+    }
+    // the mapping stays valid after close
+    close (fd);
+    return 0;
+}
+
+int map_output_file (file_map_t* map, const char* path, uint64_t size)
+{
+    int fd;
+
+    memset (map, 0, sizeof (file_map_t));
+    fd = open (path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || ftruncate (fd, size) < 0)
+    {
+        fprintf (stderr, "error %d opening %s: %s\n", errno, path, strerror (errno));
+        if (fd >= 0)
+            close (fd);
+        return -1;
+    }
+    map->size = size;
+    if (map->size > 0)
+    {
+        map->data = (uint8_t*)mmap (NULL, map->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (map->data == MAP_FAILED)
+        {
+            fprintf (stderr, "error %d mapping %s: %s\n", errno, path, strerror (errno));
+            map->data = NULL;
+            close (fd);
+            return -1;
+        }
+        map->mapped = true;
+    }
+    close (fd);
+    return 0;
+}
+
+void unmap_file (file_map_t* map)
+{
+    if (map->mapped == true)
+    {
+        msync (map->data, map->size, MS_SYNC);
+        munmap (map->data, map->size);
+    }
+    else
+        free (map->data);
+    memset (map, 0, sizeof (file_map_t));
+}
+
+uint32_t get_file_block_num (file_map_t* map, uint32_t block_length)
+{
+    return (uint32_t)((map->size + block_length - 1) / block_length);
+}
+
+uint32_t get_file_block_length (file_map_t* map, uint32_t block, uint32_t block_length)
+{
+    uint64_t offset = (uint64_t)block * block_length;
+    if (offset >= map->size)
+        return 0;
+    if (map->size - offset < block_length)
+        return (uint32_t)(map->size - offset);
+    return block_length;
+}
+
+uint16_t get_block_symbol_length (uint32_t block_length, uint16_t index, uint16_t symbol_size)
+{
+    uint32_t offset = (uint32_t)index * symbol_size;
+    if (offset >= block_length)
+        return 0;
+    if (block_length - offset < symbol_size)
+        return (uint16_t)(block_length - offset);
+    return symbol_size;
+}
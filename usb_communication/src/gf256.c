@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "gf256.h"
+
+// variable definitions
+static uint8_t m_exp_table[512];
+static uint8_t m_log_table[256];
+static bool m_initialized = false;
+
+/**
+ * @brief initialize log/exp tables of GF(2^8)
+ */
+void gf256_init (void)
+{
+    uint16_t x = 1;
+    if (m_initialized == true)
+        return;
+    for (uint16_t i = 0; i < 255; i++)
+    {
+        m_exp_table[i] = (uint8_t)x;
+        m_log_table[x] = (uint8_t)i;
+        x <<= 1;
+        if (x & 0x100)
+            x ^= GF256_POLYNOMIAL;
+    }
+    // duplicate exp table to skip the modulo in multiplication
+    for (uint16_t i = 255; i < sizeof m_exp_table; i++)
+        m_exp_table[i] = m_exp_table[i - 255];
+    m_initialized = true;
+}
+
+/**
+ * @brief multiply two field elements
+ */
+uint8_t gf256_mul (uint8_t a, uint8_t b)
+{
+    if (a == 0 || b == 0)
+        return 0;
+    return m_exp_table[m_log_table[a] + m_log_table[b]];
+}
+
+/**
+ * @brief divide two field elements, b must not be zero
+ */
+uint8_t gf256_div (uint8_t a, uint8_t b)
+{
+    if (a == 0)
+        return 0;
+    return m_exp_table[m_log_table[a] + 255 - m_log_table[b]];
+}
+
+/**
+ * @brief invert a field element, a must not be zero
+ */
+uint8_t gf256_inv (uint8_t a)
+{
+    return m_exp_table[255 - m_log_table[a]];
+}
+
+/**
+ * @brief add a buffer into another buffer: x[i] += y[i]
+ */
+void gf256_add_region (uint8_t* x, const uint8_t* y, uint32_t size)
+{
+    for (uint32_t i = 0; i < size; i++)
+        x[i] ^= y[i];
+}
+
+/**
+ * @brief multiply a buffer with a constant: x[i] *= c
+ */
+void gf256_mul_region (uint8_t* x, uint8_t c, uint32_t size)
+{
+    if (c == 1)
+        return;
+    if (c == 0)
+    {
+        memset (x, 0, size);
+        return;
+    }
+    uint8_t log_c = m_log_table[c];
+    for (uint32_t i = 0; i < size; i++)
+        if (x[i] != 0)
+            x[i] = m_exp_table[m_log_table[x[i]] + log_c];
+}
+
+/**
+ * @brief add a multiplied buffer into another buffer: x[i] += c * y[i]
+ */
+void gf256_mul_add_region (uint8_t* x, const uint8_t* y, uint8_t c, uint32_t size)
+{
+    if (c == 0)
+        return;
+    if (c == 1)
+    {
+        gf256_add_region (x, y, size);
+        return;
+    }
+    uint8_t log_c = m_log_table[c];
+    for (uint32_t i = 0; i < size; i++)
+        if (y[i] != 0)
+            x[i] ^= m_exp_table[m_log_table[y[i]] + log_c];
+}
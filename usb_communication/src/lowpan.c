@@ -18,6 +18,7 @@ static uint8_t m_first_frag_size = FIRST_FRAG_DATA_SIZE;
 static uint8_t m_other_frag_size = OTHER_FRAG_DATA_SIZE;
 static uint16_t m_datagram_tag = 0;
 static uint16_t m_current_datagram_offset = 0;
+static uint16_t m_mesh_address = MESH_BROADCAST_ADDRESS;
 
 /**
  * @brief check if a packet needs fragmentation
@@ -219,6 +220,22 @@ uint8_t* get_udp_header (uint8_t* packet)
     return packet + IPHC_TOTAL_SIZE;
 }
 
+/**
+ * @brief set the flow id, carried in the low byte of the compressed UDP source port
+ */
+void set_udp_flow (uint8_t* udphc_offset, uint8_t flow)
+{
+    *(udphc_offset + UDPHC_FLOW_OFFSET) = flow;
+}
+
+/**
+ * @brief get the flow id
+ */
+uint8_t get_udp_flow (uint8_t* udphc_offset)
+{
+    return *(udphc_offset + UDPHC_FLOW_OFFSET);
+}
+
 /**
  * @brief set UDP checksum
  */
@@ -254,47 +271,137 @@ uint8_t get_tail_size (void)
 /**
  * @brief generate an ack packet
  */
-uint8_t generate_ack_packet (uint8_t* packet, uint8_t* ack)
+uint8_t generate_ack_packet (uint8_t* packet, uint8_t ack, uint8_t sequence)
 {
-    uint8_t length = 0;
-    set_ip_header (packet);
-    set_udp_header (packet + IPHC_TOTAL_SIZE);
-    if (*ack == 'c')
-    {
-        memcpy (packet + IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE,
-                (uint8_t*)CLIENT_ACK,
-                sizeof CLIENT_ACK);
-        length = IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE + sizeof CLIENT_ACK;
-    }
-    else if (*ack == 'r')
-    {
-        memcpy (packet + IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE,
-                (uint8_t*)RELAY_ACK,
-                sizeof RELAY_ACK);
-        length = IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE + sizeof RELAY_ACK;
-    }
-    else if (*ack == 's')
-    {
-        memcpy (packet + IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE,
-                (uint8_t*)SERVER_ACK,
-                sizeof SERVER_ACK);
-        length = IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE + sizeof SERVER_ACK;
-    }
-    // set packet length in first byte of packet
-    *packet = length;
-    return length;
+    return build_control_frame (packet, ack, sequence, 0);
 }
 
 /**
- * @brief generate an ack packet
+ * @brief check if a packet is ackonwledgement or not
  */
-bool is_ack_packet (uint8_t* packet)
+bool is_ack_packet (uint8_t* packet, uint16_t length)
 {
-    if (strcmp ((char*)packet + IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE, RELAY_ACK) == 0 ||
-        strcmp ((char*)packet + IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE, SERVER_ACK) == 0)
-        return true;
-    else
+    return is_control_ack (packet, length);
+}
+
+/*
+   mesh header structure (RFC 4944, short addresses only)
+   +---+-+-+----------+------------+-------------------+
+   |1 0|V|F|hops left | originator | final destination |
+   +---+-+-+----------+------------+-------------------+
+             4 bits       2 bytes         2 bytes
+*/
+
+/**
+ * @brief check if a frame starts with a mesh header
+ */
+bool has_mesh_header (uint8_t* frame)
+{
+    return (*frame & k_mesh_dispatch_mask) == k_mesh_type_mask;
+}
+
+/**
+ * @brief set mesh header with short originator and final destination address
+ */
+uint8_t set_mesh_header (uint8_t* mesh_offset,
+                         uint16_t originator,
+                         uint16_t final_destination,
+                         uint8_t hops_left)
+{
+    if (hops_left > MESH_MAX_HOPS_LEFT)
+        hops_left = MESH_MAX_HOPS_LEFT;
+    *mesh_offset = k_mesh_type_mask |
+                   k_mesh_short_originator |
+                   k_mesh_short_final |
+                   hops_left;
+    // addresses are carried in network byte order
+    *(mesh_offset + 1) = (uint8_t)(originator >> 8);
+    *(mesh_offset + 2) = (uint8_t)originator;
+    *(mesh_offset + 3) = (uint8_t)(final_destination >> 8);
+    *(mesh_offset + 4) = (uint8_t)final_destination;
+    return MESH_HDR_SIZE;
+}
+
+/**
+ * @brief get originator address in mesh header
+ */
+uint16_t get_mesh_originator (uint8_t* mesh_offset)
+{
+    return (uint16_t)(*(mesh_offset + 1) << 8) | *(mesh_offset + 2);
+}
+
+/**
+ * @brief get final destination address in mesh header
+ */
+uint16_t get_mesh_final_destination (uint8_t* mesh_offset)
+{
+    return (uint16_t)(*(mesh_offset + 3) << 8) | *(mesh_offset + 4);
+}
+
+/**
+ * @brief get hops left in mesh header
+ */
+uint8_t get_mesh_hops_left (uint8_t* mesh_offset)
+{
+    return *mesh_offset & k_mesh_hops_left_mask;
+}
+
+/**
+ * @brief decrement hops left in mesh header, return false if no hop is left
+ */
+bool decrement_mesh_hops_left (uint8_t* mesh_offset)
+{
+    uint8_t hops_left = get_mesh_hops_left (mesh_offset);
+    if (hops_left == 0)
         return false;
+    *mesh_offset = (*mesh_offset & ~k_mesh_hops_left_mask) | (hops_left - 1);
+    return true;
+}
+
+/**
+ * @brief prepend a mesh header to a frame, return new frame length or 0
+ */
+uint16_t add_mesh_header (virtual_packet_t* tx_packet,
+                          uint16_t originator,
+                          uint16_t final_destination,
+                          uint8_t hops_left)
+{
+    if (tx_packet->length + MESH_HDR_SIZE > MAX_MSDU_SIZE)
+        return 0;
+    memmove (tx_packet->packet + MESH_HDR_SIZE, tx_packet->packet, tx_packet->length);
+    set_mesh_header (tx_packet->packet, originator, final_destination, hops_left);
+    tx_packet->length += MESH_HDR_SIZE;
+    return tx_packet->length;
+}
+
+/**
+ * @brief strip the mesh header from a frame, return new frame length
+ */
+uint16_t remove_mesh_header (uint8_t* frame, uint16_t length)
+{
+    if (has_mesh_header (frame) == false || length < MESH_HDR_SIZE)
+        return length;
+    memmove (frame, frame + MESH_HDR_SIZE, length - MESH_HDR_SIZE);
+    return length - MESH_HDR_SIZE;
+}
+
+/**
+ * @brief set own mesh address
+ */
+void set_mesh_address (uint16_t address)
+{
+    m_mesh_address = address;
+}
+
+/**
+ * @brief check if a mesh frame is addressed to this node
+ */
+bool is_mesh_for_me (uint8_t* mesh_offset)
+{
+    uint16_t final_destination = get_mesh_final_destination (mesh_offset);
+    return m_mesh_address == MESH_BROADCAST_ADDRESS ||
+           final_destination == MESH_BROADCAST_ADDRESS ||
+           final_destination == m_mesh_address;
 }
 
 /**
@@ -0,0 +1,124 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "nc_field.h"
+
+/*
+   Finite field of the coding vectors. Client, relay and server must code
+   over the same field, so the field id travels in the NC header. Smaller
+   fields are cheaper to compute on a weak host and shrink the coding
+   vector, larger fields make a random combination less likely to be
+   linearly dependent.
+   element layout in a packed coding vector, matching kodo:
+   binary:      8 elements per byte, element 0 in the least significant bit
+   binary4:     2 elements per byte, element 0 in the low nibble
+   binary8:     1 byte per element
+   binary16:    2 bytes per element, little endian
+   prime2325:   4 bytes per element, little endian, values below 2^32 - 5
+*/
+
+#define PRIME2325 4294967291U   // 2^32 - 5
+
+static const char* field_names[NC_FIELD_NUM] = {"binary", "binary4", "binary8", "binary16", "prime2325"};
+static const uint8_t field_bits[NC_FIELD_NUM] = {1, 4, 8, 16, 32};
+
+bool parse_field_name (const char* name, uint8_t* field)
+{
+    for (uint8_t i = 0; i < NC_FIELD_NUM; i++)
+    {
+        if (strcmp (name, field_names[i]) == 0)
+        {
+            *field = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* get_field_name (uint8_t field)
+{
+    if (field >= NC_FIELD_NUM)
+        return "unknown";
+    return field_names[field];
+}
+
+uint8_t get_field_bits (uint8_t field)
+{
+    if (field >= NC_FIELD_NUM)
+        return 0;
+    return field_bits[field];
+}
+
+uint32_t get_field_vector_size (uint8_t field, uint32_t symbols)
+{
+    return (symbols * get_field_bits (field) + 7) / 8;
+}
+
+void set_field_value (uint8_t* elements, uint8_t field, uint32_t index, uint32_t value)
+{
+    switch (field)
+    {
+        case NC_FIELD_BINARY:
+            if (value & 1)
+                elements[index / 8] |= (uint8_t)(1 << (index % 8));
+            else
+                elements[index / 8] &= (uint8_t)~(1 << (index % 8));
+            break;
+        case NC_FIELD_BINARY4:
+            if (index % 2 == 0)
+                elements[index / 2] = (elements[index / 2] & 0xf0) | (value & 0x0f);
+            else
+                elements[index / 2] = (elements[index / 2] & 0x0f) | (uint8_t)((value & 0x0f) << 4);
+            break;
+        case NC_FIELD_BINARY8:
+            elements[index] = (uint8_t)value;
+            break;
+        case NC_FIELD_BINARY16:
+            elements[2 * index] = (uint8_t)value;
+            elements[2 * index + 1] = (uint8_t)(value >> 8);
+            break;
+        case NC_FIELD_PRIME2325:
+            for (uint8_t i = 0; i < 4; i++)
+                elements[4 * index + i] = (uint8_t)(value >> (8 * i));
+            break;
+    }
+}
+
+uint32_t get_field_value (const uint8_t* elements, uint8_t field, uint32_t index)
+{
+    uint32_t value = 0;
+    switch (field)
+    {
+        case NC_FIELD_BINARY:
+            return (elements[index / 8] >> (index % 8)) & 1;
+        case NC_FIELD_BINARY4:
+            return (elements[index / 2] >> (4 * (index % 2))) & 0x0f;
+        case NC_FIELD_BINARY8:
+            return elements[index];
+        case NC_FIELD_BINARY16:
+            return (uint32_t)elements[2 * index] | ((uint32_t)elements[2 * index + 1] << 8);
+        case NC_FIELD_PRIME2325:
+            for (uint8_t i = 0; i < 4; i++)
+                value |= (uint32_t)elements[4 * index + i] << (8 * i);
+            return value;
+    }
+    return 0;
+}
+
+uint32_t get_nonzero_field_value (uint8_t field, uint32_t random)
+{
+    switch (field)
+    {
+        case NC_FIELD_BINARY:
+            return 1;
+        case NC_FIELD_BINARY4:
+            return random % 15 + 1;
+        case NC_FIELD_BINARY16:
+            return random % 65535 + 1;
+        case NC_FIELD_PRIME2325:
+            return random % (PRIME2325 - 1) + 1;
+        default:
+            return random % 255 + 1;
+    }
+}
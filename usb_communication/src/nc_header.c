@@ -0,0 +1,113 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "nc_header.h"
+#include "coding_vector.h"
+
+/*
+   NC packet structure, in front of it are the compressed IP/UDP headers
+   +---------+------+-------+------------+-------+---------+---------------+--------+
+   | version | type | flags | generation | field | length  | type specific | symbol |
+   +---------+------+-------+------------+-------+---------+---------------+--------+
+     2 bits  2 bits 4 bits     1 byte     3 bits  13 bits
+   type specific part:
+   systematic: symbol index (1 byte)
+   coded:      coding vector (coefficient vector size of the generation)
+   seeded:     seed (2 bytes) + density (1 byte)
+   payload:    none, the kodo payload has its own coding header
+   length is the number of symbol bytes that follow, so the last source
+   symbol of a generation can be shorter than the symbol size.
+   field is the nc_field_t the coding vector is defined over, a receiver
+   drops packets of another field instead of decoding garbage.
+*/
+
+uint16_t get_nc_max_header_size (uint16_t coefficient_size)
+{
+    uint16_t size = NC_INDEX_SIZE;
+    if (coefficient_size > size)
+        size = coefficient_size;
+    if (SEED_HDR_SIZE > size)
+        size = SEED_HDR_SIZE;
+    return NC_HDR_SIZE + size;
+}
+
+uint16_t write_nc_packet (uint8_t* nc_packet, nc_header_t* header)
+{
+    uint8_t* offset = nc_packet + NC_HDR_SIZE;
+
+    *nc_packet = (NC_HEADER_VERSION << 6) |
+                 ((header->type << 4) & k_nc_type_mask) |
+                 (header->flags & k_nc_flags_mask);
+    *(nc_packet + 1) = header->generation_id;
+    *(nc_packet + 2) = ((header->field << 5) & k_nc_field_mask) |
+                       (uint8_t)((header->length & k_nc_length_mask) >> 8);
+    *(nc_packet + 3) = (uint8_t)header->length;
+    switch (header->type)
+    {
+        case NC_SYSTEMATIC:
+            *offset = header->index;
+            offset += NC_INDEX_SIZE;
+            break;
+        case NC_CODED:
+            memcpy (offset, header->coefficients, header->coefficient_size);
+            offset += header->coefficient_size;
+            break;
+        case NC_SEEDED:
+            set_seed_header (offset, header->seed, header->density);
+            offset += SEED_HDR_SIZE;
+            break;
+        case NC_PAYLOAD:
+            break;
+        default:
+            return 0;
+    }
+    memcpy (offset, header->symbol, header->length);
+    return (uint16_t)(offset - nc_packet) + header->length;
+}
+
+bool parse_nc_packet (uint8_t* nc_packet,
+                      uint16_t length,
+                      uint16_t coefficient_size,
+                      uint16_t symbol_size,
+                      nc_header_t* header)
+{
+    uint16_t header_size = NC_HDR_SIZE;
+
+    if (length < NC_HDR_SIZE ||
+        (*nc_packet & k_nc_version_mask) >> 6 != NC_HEADER_VERSION)
+        return false;
+    header->type = (*nc_packet & k_nc_type_mask) >> 4;
+    header->flags = *nc_packet & k_nc_flags_mask;
+    header->generation_id = *(nc_packet + 1);
+    header->field = (*(nc_packet + 2) & k_nc_field_mask) >> 5;
+    header->length = ((uint16_t)(*(nc_packet + 2) << 8) | *(nc_packet + 3)) & k_nc_length_mask;
+    switch (header->type)
+    {
+        case NC_SYSTEMATIC:
+            header->index = *(nc_packet + header_size);
+            header_size += NC_INDEX_SIZE;
+            break;
+        case NC_CODED:
+            header->coefficients = nc_packet + header_size;
+            header->coefficient_size = coefficient_size;
+            header_size += coefficient_size;
+            break;
+        case NC_SEEDED:
+            header->seed = get_seed (nc_packet + header_size);
+            header->density = get_seed_density (nc_packet + header_size);
+            header_size += SEED_HDR_SIZE;
+            break;
+        case NC_PAYLOAD:
+            header->symbol = nc_packet + header_size;
+            return length >= header_size + header->length;
+        default:
+            return false;
+    }
+    if (header->length > symbol_size || length < header_size + header->length)
+        return false;
+    header->symbol = nc_packet + header_size;
+    // pad a short tail symbol
+    memset (header->symbol + header->length, 0, symbol_size - header->length);
+    return true;
+}
@@ -0,0 +1,67 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "packet_queue.h"
+
+/*
+   Hands reassembled packets from a receiving thread to a transmitting
+   thread without a lock. Only the producer moves the tail and only the
+   consumer moves the head, so each index has a single writer: the
+   release store of an index publishes the slot it covers, and the
+   acquire load on the other side sees the slot contents before the
+   index. The counters run freely and are masked on access.
+*/
+
+void init_packet_queue (packet_queue_t* queue)
+{
+    memset (queue->lengths, 0, sizeof queue->lengths);
+    queue->head = 0;
+    queue->tail = 0;
+    queue->drop_count = 0;
+    queue->closed = false;
+}
+
+bool packet_queue_push (packet_queue_t* queue, const uint8_t* packet, uint16_t length)
+{
+    uint32_t tail = queue->tail;
+    uint32_t head = __atomic_load_n (&queue->head, __ATOMIC_ACQUIRE);
+    uint32_t slot = tail & (PACKET_QUEUE_LENGTH - 1);
+
+    if (tail - head == PACKET_QUEUE_LENGTH || length > MAX_PACKET_SIZE)
+    {
+        queue->drop_count++;
+        return false;
+    }
+    memcpy (queue->packets[slot], packet, length);
+    queue->lengths[slot] = length;
+    __atomic_store_n (&queue->tail, tail + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+uint16_t packet_queue_pop (packet_queue_t* queue, uint8_t* packet)
+{
+    uint32_t head = queue->head;
+    uint32_t tail = __atomic_load_n (&queue->tail, __ATOMIC_ACQUIRE);
+    uint32_t slot = head & (PACKET_QUEUE_LENGTH - 1);
+    uint16_t length;
+
+    if (head == tail)
+        return 0;
+    length = queue->lengths[slot];
+    memcpy (packet, queue->packets[slot], length);
+    __atomic_store_n (&queue->head, head + 1, __ATOMIC_RELEASE);
+    return length;
+}
+
+void close_packet_queue (packet_queue_t* queue)
+{
+    __atomic_store_n (&queue->closed, true, __ATOMIC_RELEASE);
+}
+
+bool is_packet_queue_drained (packet_queue_t* queue)
+{
+    // closed first, a packet pushed before closing is then seen by the tail load
+    return __atomic_load_n (&queue->closed, __ATOMIC_ACQUIRE) == true &&
+           __atomic_load_n (&queue->tail, __ATOMIC_ACQUIRE) == queue->head;
+}
@@ -0,0 +1,57 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "rank_tracker.h"
+
+/*
+   A relay only needs to know whether a packet adds to the span of what it
+   holds, not the decoded data. The tracker is a kodo decoder with one byte
+   symbols fed with the coding vectors and a dummy symbol, so the
+   elimination runs on the coefficients at almost no cost per symbol byte.
+*/
+
+void init_rank_tracker (rank_tracker_t* tracker, fifi::finite_field field, uint32_t generation_size)
+{
+    tracker->decoder = new kodo_rlnc::decoder (field, generation_size, 1);
+    tracker->storage = new uint8_t[tracker->decoder->block_size()];
+    tracker->coefficient_size = tracker->decoder->coefficient_vector_size();
+    tracker->coefficients = new uint8_t[tracker->coefficient_size];
+    tracker->symbol = 0;
+    tracker->decoder->set_symbols_storage (tracker->storage);
+}
+
+void reset_rank_tracker (rank_tracker_t* tracker)
+{
+    tracker->decoder->reset ();
+    tracker->decoder->set_symbols_storage (tracker->storage);
+}
+
+bool track_coded_symbol (rank_tracker_t* tracker, const uint8_t* coefficients)
+{
+    uint32_t rank = tracker->decoder->rank ();
+    memcpy (tracker->coefficients, coefficients, tracker->coefficient_size);
+    tracker->decoder->consume_symbol (&tracker->symbol, tracker->coefficients);
+    return tracker->decoder->rank () > rank;
+}
+
+bool track_systematic_symbol (rank_tracker_t* tracker, uint32_t index)
+{
+    uint32_t rank = tracker->decoder->rank ();
+    if (index >= tracker->decoder->symbols())
+        return false;
+    tracker->decoder->consume_systematic_symbol (&tracker->symbol, index);
+    return tracker->decoder->rank () > rank;
+}
+
+uint32_t get_tracked_rank (rank_tracker_t* tracker)
+{
+    return tracker->decoder->rank ();
+}
+
+void free_rank_tracker (rank_tracker_t* tracker)
+{
+    delete tracker->decoder;
+    delete[] tracker->storage;
+    delete[] tracker->coefficients;
+}
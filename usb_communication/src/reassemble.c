@@ -10,6 +10,10 @@
 #include "reassemble.h"
 #include "utils.h"
 
+#ifndef REASSEMBLE_LOG_ON
+#define REASSEMBLE_LOG_ON true
+#endif
+
 // variable definitions
 static reassembler_t m_reassembler;
 
@@ -41,7 +45,8 @@ void init_reassembler (void)
 uint8_t read_frame (uint8_t* frame, uint16_t length)
 {
     copy_payload (frame, length);
-    printf ("filled size: %u\n", m_reassembler.filled_size);
+    if (REASSEMBLE_LOG_ON == true)
+        printf ("filled size: %u\n", m_reassembler.filled_size);
     if (m_reassembler.rx_num_order[m_reassembler.current_frame] == length &&
         m_reassembler.current_frame != m_reassembler.fragment_num)
     {
@@ -59,7 +64,8 @@ uint8_t read_frame (uint8_t* frame, uint16_t length)
  */
 void start_new_reassemble (uint8_t* frame)
 {
-    printf ("start new reassemble process\nnew tag: %u\n", get_datagram_tag (frame + 2));
+    if (REASSEMBLE_LOG_ON == true)
+        printf ("start new reassemble process\nnew tag: %u\n", get_datagram_tag (frame + 2));
     init_reassembler ();
     m_reassembler.idle = false;
     m_reassembler.datagram_tag = get_datagram_tag (frame + 2);
@@ -71,6 +77,31 @@ void start_new_reassemble (uint8_t* frame)
     m_reassembler.current_frame = 0;
 }
 
+/**
+ * @brief feed a fragment into the reassembler, return false if it is not accepted
+ */
+bool reassemble_fragment (uint8_t* frame, uint16_t length)
+{
+    // receive first frame of a packet
+    // and make sure part of the payload is
+    // included to avoid segmentation fault
+    if (is_first_fragment (frame) == true &&
+        length > FIRST_FRAG_DATA_OFFSET)
+    {
+        start_new_reassemble (frame);
+        read_frame (frame, length);
+    }
+    // receive a fragment of a known packet
+    else if (is_reassembler_running () == true &&
+             is_new_packet (frame) == false &&
+             is_new_fragment (frame) == true)
+        read_frame (frame, length);
+    // other cases
+    else
+        return false;
+    return true;
+}
+
 /**
  * @brief calculate rx number order
  */
@@ -107,7 +138,8 @@ uint8_t copy_frame_tail (uint8_t* frame_tail, uint8_t length)
             frame_tail,
             length);
     m_reassembler.filled_size += length;
-    printf ("filled size: %u\n", m_reassembler.filled_size);
+    if (REASSEMBLE_LOG_ON == true)
+        printf ("filled size: %u\n", m_reassembler.filled_size);
     m_reassembler.current_frame++;
     return m_reassembler.rx_num_order[m_reassembler.current_frame];
 }
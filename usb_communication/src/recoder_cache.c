@@ -0,0 +1,122 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "recoder_cache.h"
+#include "nc_field.h"
+
+/*
+   A relay on a shared channel overhears generations of several sources,
+   and the generations of one source overlap when the client pipelines
+   them. The cache keeps one pure recoder per (flow, generation) so a late
+   packet of an older generation is still recoded with its own symbols.
+   Constructing a kodo coder allocates, so recoders are built once, up to
+   the memory budget, and then recycled with reset(): the least recently
+   used generation gives its recoder to the new one.
+*/
+
+static void construct_entry (recoder_cache_t* cache, recoder_entry_t* entry)
+{
+    fifi::finite_field field = (fifi::finite_field)cache->field_id;
+    entry->recoder = new kodo_rlnc::pure_recoder (field,
+                                                  cache->generation_size,
+                                                  cache->symbol_size,
+                                                  cache->recoder_symbols);
+    init_rank_tracker (&entry->tracker, field, cache->generation_size);
+    entry->used = false;
+}
+
+uint32_t get_recoder_memory (uint8_t field_id,
+                             uint32_t generation_size,
+                             uint32_t symbol_size,
+                             uint32_t recoder_symbols)
+{
+    uint32_t coefficient_size = get_field_vector_size (field_id, generation_size);
+    // stored combinations plus the coding vectors the tracker eliminates
+    return recoder_symbols * (symbol_size + coefficient_size) +
+           generation_size * (1 + coefficient_size);
+}
+
+void init_recoder_cache (recoder_cache_t* cache,
+                         uint8_t field_id,
+                         uint32_t generation_size,
+                         uint32_t symbol_size,
+                         uint32_t recoder_symbols,
+                         uint32_t memory_budget)
+{
+    memset (cache, 0, sizeof (recoder_cache_t));
+    cache->field_id = field_id;
+    cache->generation_size = generation_size;
+    cache->symbol_size = symbol_size;
+    cache->recoder_symbols = recoder_symbols;
+    cache->capacity = memory_budget / get_recoder_memory (field_id,
+                                                          generation_size,
+                                                          symbol_size,
+                                                          recoder_symbols);
+    if (cache->capacity < 1)
+        cache->capacity = 1;
+    if (cache->capacity > RECODER_CACHE_MAX_ENTRIES)
+        cache->capacity = RECODER_CACHE_MAX_ENTRIES;
+    cache->entries = new recoder_entry_t[cache->capacity];
+    memset (cache->entries, 0, sizeof (recoder_entry_t) * cache->capacity);
+    construct_entry (cache, &cache->entries[0]);
+    cache->size = 1;
+}
+
+recoder_entry_t* get_cached_recoder (recoder_cache_t* cache,
+                                     uint8_t flow,
+                                     uint8_t generation_id,
+                                     bool* fresh)
+{
+    recoder_entry_t* entry = NULL;
+    recoder_entry_t* victim = NULL;
+
+    cache->clock++;
+    for (uint32_t i = 0; i < cache->size; i++)
+    {
+        entry = &cache->entries[i];
+        if (entry->used == true &&
+            entry->flow == flow &&
+            entry->generation_id == generation_id)
+        {
+            entry->last_use = cache->clock;
+            cache->hit_count++;
+            *fresh = false;
+            return entry;
+        }
+        if (victim == NULL ||
+            (victim->used == true && (entry->used == false || entry->last_use < victim->last_use)))
+            victim = entry;
+    }
+    cache->miss_count++;
+    // an idle recoder first, then a new one while the budget lasts, then the least recent
+    if (victim->used == true && cache->size < cache->capacity)
+    {
+        victim = &cache->entries[cache->size];
+        construct_entry (cache, victim);
+        cache->size++;
+    }
+    else if (victim->used == true)
+        cache->eviction_count++;
+    victim->recoder->reset ();
+    reset_rank_tracker (&victim->tracker);
+    victim->flow = flow;
+    victim->generation_id = generation_id;
+    victim->used = true;
+    victim->last_use = cache->clock;
+    victim->repair_budget = 0;
+    victim->repair_due = 0;
+    victim->last_rx_time = 0;
+    *fresh = true;
+    return victim;
+}
+
+void free_recoder_cache (recoder_cache_t* cache)
+{
+    for (uint32_t i = 0; i < cache->size; i++)
+    {
+        delete cache->entries[i].recoder;
+        free_rank_tracker (&cache->entries[i].tracker);
+    }
+    delete[] cache->entries;
+}
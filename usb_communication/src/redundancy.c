@@ -0,0 +1,87 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "redundancy.h"
+
+/*
+   Every received coded packet is assumed to be innovative, which holds
+   closely for RLNC over GF(2^8). A generation of g symbols sent in n
+   packets with loss rate p is then decoded when at least g of n
+   Bernoulli(1 - p) trials succeed.
+*/
+
+void init_loss_estimator (loss_estimator_t* estimator, float alpha, float initial_loss)
+{
+    estimator->loss = initial_loss;
+    estimator->alpha = alpha;
+}
+
+void update_loss_estimator (loss_estimator_t* estimator, uint16_t tx_num, uint16_t rx_num)
+{
+    float sample;
+    if (tx_num == 0)
+        return;
+    if (rx_num > tx_num)
+        rx_num = tx_num;
+    sample = 1 - (float)rx_num / tx_num;
+    estimator->loss = estimator->alpha * sample + (1 - estimator->alpha) * estimator->loss;
+}
+
+/**
+ * @brief probability of receiving fewer than k of n packets
+ */
+static double get_binomial_lower_tail (uint16_t n, uint16_t k, double loss)
+{
+    double tail = 0;
+    // every term is computed in the log domain to stay finite for large n
+    for (uint16_t i = 0; i < k && i <= n; i++)
+        tail += exp (lgamma (n + 1) - lgamma (i + 1) - lgamma (n - i + 1) +
+                     i * log (1 - loss) + (n - i) * log (loss));
+    return tail;
+}
+
+uint16_t get_adaptive_tx_num (uint16_t generation_size,
+                              float loss,
+                              float target,
+                              uint16_t max_tx_num)
+{
+    if (loss <= 0)
+        return generation_size;
+    if (loss >= 1)
+        return max_tx_num;
+    for (uint16_t n = generation_size; n < max_tx_num; n++)
+        if (1 - get_binomial_lower_tail (n, generation_size, loss) >= target)
+            return n;
+    return max_tx_num;
+}
+
+/**
+ * @brief probability that k random vectors over GF(2^field_bits) span a generation
+ */
+static double get_full_rank_probability (uint16_t generation_size, uint16_t k, uint8_t field_bits)
+{
+    double probability = 1;
+    // factors of the surplus rows beyond 64 bits are 1 in double precision
+    for (uint16_t j = k - generation_size + 1; j <= k && (uint32_t)j * field_bits < 64; j++)
+        probability *= 1 - pow (2, -(double)field_bits * j);
+    return probability;
+}
+
+double get_decode_probability (uint16_t generation_size,
+                               uint16_t tx_num,
+                               float loss,
+                               uint8_t field_bits)
+{
+    double probability = 0;
+    if (loss >= 1 || tx_num < generation_size)
+        return 0;
+    if (loss <= 0)
+        return get_full_rank_probability (generation_size, tx_num, field_bits);
+    // k of tx_num packets are received and the received ones have full rank
+    for (uint16_t k = generation_size; k <= tx_num; k++)
+        probability += exp (lgamma (tx_num + 1) - lgamma (k + 1) - lgamma (tx_num - k + 1) +
+                            k * log (1 - loss) + (tx_num - k) * log (loss)) *
+                       get_full_rank_probability (generation_size, k, field_bits);
+    return probability;
+}
@@ -6,16 +6,21 @@
 #include <unistd.h>
 #include <sys/time.h>
 #include <time.h>
+#include <pthread.h>
 
 #include "serial.h"
 #include "lowpan.h"
 #include "reassemble.h"
+#include "fec.h"
 #include "utils.h"
 #include "config.h"
 
 
 // variable definitions
 static tx_buf_t m_tx_buf;
+// a frame written in two serial fragments must reach the dongle in one piece,
+// the ACK a receiving thread sends must not land between them
+static pthread_mutex_t m_write_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 int open_serial_port (char* port, int speed, int parity)
 {
@@ -92,6 +97,7 @@ void set_blocking (int fd, int should_block)
 int write_serial_port (int fd, uint8_t* data, int length)
 {
     int ret;
+    pthread_mutex_lock (&m_write_mutex);
     if (need_serial_fragmentation (length) == true)
     {
         tx_buf_t* tx_buffer;
@@ -99,31 +105,19 @@ int write_serial_port (int fd, uint8_t* data, int length)
         tx_buffer = serial_fragmentation (data, length);
         // send first serial fragment
         ret = write (fd, tx_buffer->buf_0, tx_buffer->buf_0_size);
-        if (ret < 0)
-        {
-            fprintf (stderr, "error %d write fail: %s\n", errno, strerror (errno));
-            return -1;
-        }
         // send second serial fragment
-        ret = write (fd, tx_buffer->buf_1, tx_buffer->buf_1_size);
-        if (ret < 0)
-        {
-            fprintf (stderr, "error %d write fail: %s\n", errno, strerror (errno));
-            return -1;
-        }
-        return 0;
+        if (ret >= 0)
+            ret = write (fd, tx_buffer->buf_1, tx_buffer->buf_1_size);
     }
     else
-    {
         ret = write (fd, data, length);
-        if (ret < 0)
-        {
-            fprintf (stderr, "error %d write fail: %s\n", errno, strerror (errno));
-            return -1;
-        }
-        else
-            return 0;
+    pthread_mutex_unlock (&m_write_mutex);
+    if (ret < 0)
+    {
+        fprintf (stderr, "error %d write fail: %s\n", errno, strerror (errno));
+        return -1;
     }
+    return 0;
 }
 
 bool need_serial_fragmentation (int length)
@@ -144,6 +138,47 @@ tx_buf_t* serial_fragmentation (uint8_t* data, int length)
     return &m_tx_buf;
 }
 
+uint8_t calculate_frame_length (uint8_t* frame)
+{
+    uint16_t datagram_size = 0;
+    uint8_t fragment_num = 0;
+    uint8_t rx_num_order[MAX_FRAG_NUM];
+    uint16_t sum = 0;
+
+    // control frame
+    if (is_control_frame (frame) == true)
+        return get_control_frame_length (frame);
+    // mesh addressed frame
+    if (has_mesh_header (frame) == true)
+        return MESH_HDR_SIZE + calculate_frame_length (frame + MESH_HDR_SIZE);
+    // FEC fragment
+    if (is_fec_fragment (frame) == true)
+        return calculate_fec_frame_length (frame);
+    // non-fragmented/normal packet
+    if (need_reassemble (frame) == false)
+        return *frame;
+
+    // fragmented packet
+    memset (rx_num_order, 0, sizeof rx_num_order);
+    datagram_size = get_datagram_size (frame);
+    fragment_num = calculate_fragment_num (datagram_size);
+    calculate_rx_num_order (rx_num_order, fragment_num, datagram_size);
+    if (is_first_fragment (frame) == true)
+        return rx_num_order[0];
+    for (uint8_t i = 1; i < fragment_num; i++)
+    {
+        sum = 0;
+        for (uint8_t j = 0; j < i; j++)
+            if (j == 0)
+                sum += rx_num_order[j] - FIRST_FRAG_HDR_SIZE;
+            else
+                sum += rx_num_order[j] - OTHER_FRAG_HDR_SIZE;
+        if (sum == get_datagram_offset (frame + 4))
+            return rx_num_order[i];
+    }
+    return 0;
+}
+
 uint16_t read_serial_port (int fd, uint8_t* extract_buf, uint16_t* rx_frame_count, bool frame_only)
 {
     // parameter definitions
@@ -152,9 +187,8 @@ uint16_t read_serial_port (int fd, uint8_t* extract_buf, uint16_t* rx_frame_coun
     memset (rx_buf, 0, sizeof rx_buf);
     bool read_complete = false;
     int ret = 0;
-    uint8_t ack_packet[64];
-    // construct ack packet
-    uint8_t ack_packet_length = generate_ack_packet (ack_packet, (uint8_t*)SERVER_ACK);
+    uint8_t ack_packet[CONTROL_MAX_SIZE];
+    uint8_t ack_packet_length = 0;
 
     // time related variable definition
     uint32_t packet_rx_timeout = 1500; // ms, hard coded
@@ -162,58 +196,47 @@ uint16_t read_serial_port (int fd, uint8_t* extract_buf, uint16_t* rx_frame_coun
 
     uint8_t current_frame_length = 0;
     uint8_t init_rx_size = 10;
-    uint16_t datagram_size = 0;
-    uint8_t fragment_num = 0;
-    uint8_t rx_num_order[MAX_FRAG_NUM];
-    memset (rx_num_order, 0, sizeof rx_num_order);
-    uint16_t sum = 0;
 
     init_reassembler();
+    init_fec_reassembler();
 
     packet_rx_timeout_start = clock();
     while (read_complete == false)
     {
         if ((clock() - packet_rx_timeout_start) * 1000 / CLOCKS_PER_SEC > packet_rx_timeout)
             return 0;
-        // read from serial port
-        rx_num = read (fd, rx_buf, init_rx_size);
+        // read from serial port, a control frame may be shorter than init_rx_size
+        rx_num = read (fd, rx_buf, CONTROL_HDR_SIZE);
         if (rx_num > 0)
         {
-            // fragmented packet
-            if (need_reassemble (rx_buf) == true)
+            while (rx_num < CONTROL_HDR_SIZE)
             {
-                datagram_size = get_datagram_size (rx_buf);
-                fragment_num = calculate_fragment_num (datagram_size);
-                calculate_rx_num_order (rx_num_order, fragment_num, datagram_size);
-
-                if (is_first_fragment (rx_buf) == true)
-                    current_frame_length = rx_num_order[0];
-                else
+                ret = read (fd, rx_buf + rx_num, CONTROL_HDR_SIZE - rx_num);
+                if (ret > 0)
+                    rx_num += ret;
+            }
+            if (is_control_frame (rx_buf) == false)
+                while (rx_num < init_rx_size)
                 {
-                    for (uint8_t i = 1; i < fragment_num; i++)
-                    {
-                        sum = 0;
-                        for (uint8_t j = 0; j < i; j++)
-                            if (j == 0)
-                                sum += rx_num_order[j] - FIRST_FRAG_HDR_SIZE;
-                            else
-                                sum += rx_num_order[j] - OTHER_FRAG_HDR_SIZE;
-                        if (sum == get_datagram_offset (rx_buf + 4))
-                        {
-                            current_frame_length = rx_num_order[i];
-                            break;
-                        }
-                    }
+                    ret = read (fd, rx_buf + rx_num, init_rx_size - rx_num);
+                    if (ret > 0)
+                        rx_num += ret;
                 }
-            }
-            // non-fragmented/normal packet
-            else
-                current_frame_length = *rx_buf;
-            do
+            // make sure the header behind a mesh header is available
+            if (has_mesh_header (rx_buf) == true)
+                while (rx_num < init_rx_size + MESH_HDR_SIZE)
+                {
+                    ret = read (fd, rx_buf + rx_num, init_rx_size + MESH_HDR_SIZE - rx_num);
+                    if (ret > 0)
+                        rx_num += ret;
+                }
+            current_frame_length = calculate_frame_length (rx_buf);
+            while (rx_num < current_frame_length)
             {
-                rx_num += read (fd, rx_buf + rx_num, 1);
+                ret = read (fd, rx_buf + rx_num, 1);
+                if (ret > 0)
+                    rx_num += ret;
             }
-            while (rx_num < current_frame_length);
             printf ("receive %d bytes\n", rx_num);
         }
         else if (rx_num == -1)
@@ -221,7 +244,8 @@ uint16_t read_serial_port (int fd, uint8_t* extract_buf, uint16_t* rx_frame_coun
             fprintf (stderr, "error %d read fail: %s\n", errno,  strerror (errno));
             break;
         }
-        else if (is_reassembler_running() == true)
+        else if (is_reassembler_running() == true ||
+                 is_fec_reassembler_running() == true)
             continue;
         else
             return 0;
@@ -242,6 +266,45 @@ uint16_t read_serial_port (int fd, uint8_t* extract_buf, uint16_t* rx_frame_coun
             return (uint16_t)rx_num;
         }
 
+        // control frames are not reassembled
+        if (is_control_frame (rx_buf) == true)
+        {
+            memcpy (extract_buf, rx_buf, rx_num);
+            return (uint16_t)rx_num;
+        }
+
+        // strip mesh header, drop frames routed to another node
+        if (has_mesh_header (rx_buf) == true)
+        {
+            if (is_mesh_for_me (rx_buf) == false)
+            {
+                memset (rx_buf, 0, sizeof rx_buf);
+                continue;
+            }
+            rx_num = remove_mesh_header (rx_buf, rx_num);
+        }
+
+        // FEC fragment, any k fragments rebuild the packet
+        if (is_fec_fragment (rx_buf) == true)
+        {
+            // send ack
+            printf ("send ACK\n");
+            ack_packet_length = generate_ack_packet (ack_packet,
+                                                     SERVER_ACK,
+                                                     (uint8_t)get_datagram_tag (rx_buf + 2));
+            ret = write_serial_port (fd, ack_packet, ack_packet_length);
+            if (ret == -1)
+                return 0;
+            if (read_fec_fragment (rx_buf, rx_num) == true &&
+                is_fec_reassemble_complete () == true)
+            {
+                printf ("packet FEC reassemble complete!\n");
+                return extract_fec_packet (extract_buf);
+            }
+            memset (rx_buf, 0, sizeof rx_buf);
+            continue;
+        }
+
         // check if frame is correctly formatted
         if (is_frame_format_correct (rx_buf) == false)
         {
@@ -255,25 +318,13 @@ uint16_t read_serial_port (int fd, uint8_t* extract_buf, uint16_t* rx_frame_coun
         {
             // send ack
             printf ("send ACK\n");
+            ack_packet_length = generate_ack_packet (ack_packet,
+                                                     SERVER_ACK,
+                                                     (uint8_t)get_datagram_tag (rx_buf + 2));
             ret = write_serial_port (fd, ack_packet, ack_packet_length);
             if (ret == -1)
                 return 0;
-            // receive first frame of a packet
-            // and make sure part of the payload is
-            // included to avoid segmentation fault
-            if (is_first_fragment (rx_buf) == true &&
-                rx_num > FIRST_FRAG_DATA_OFFSET)
-            {
-                start_new_reassemble (rx_buf);
-                read_frame (rx_buf, rx_num);
-            }
-            // receive a fragment of a known packet
-            else if (is_reassembler_running () == true &&
-                     is_new_packet (rx_buf) == false &&
-                     is_new_fragment (rx_buf) == true)
-                read_frame (rx_buf, rx_num);
-            // other cases
-            else
+            if (reassemble_fragment (rx_buf, rx_num) == false)
             {
                 memset (rx_buf, 0, sizeof rx_buf);
                 continue;
@@ -310,9 +361,7 @@ bool wait_ack (int fd, uint16_t ack_timeout)
     {
         // check for ack from server
         rx_num = read_serial_port (fd, rx_buf, NULL, false);
-        if (rx_num > 0 &&
-            (strcmp ((const char*)(rx_buf + IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE), RELAY_ACK) == 0 ||
-             strcmp ((const char*)(rx_buf + IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE), SERVER_ACK) == 0))
+        if (rx_num > 0 && is_ack_packet (rx_buf, rx_num) == true)
             return true;
         else if (rx_num == -1)
         {
@@ -0,0 +1,274 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "sliding_window.h"
+#include "gf256.h"
+
+/*
+   sliding window packet structure
+   systematic:
+   +------+----------+--------+
+   | 0x00 | sequence | symbol |
+   +------+----------+--------+
+            2 bytes
+   repair:
+   +------+--------------+--------------+--------------+--------+
+   | 0x01 | window start | window count | coefficients | symbol |
+   +------+--------------+--------------+--------------+--------+
+              2 bytes        1 byte       count bytes
+
+   A repair packet combines every source symbol that the receiver has not
+   acknowledged yet. The receiver keeps its rows in reduced echelon form
+   indexed by pivot sequence, so a symbol is released as soon as it and all
+   symbols before it are decoded.
+*/
+
+#define SW_SLOT(seq) ((seq) & (SW_MAX_WINDOW_SIZE - 1))
+
+/**
+ * @brief write a sequence number in big endian
+ */
+static void set_sliding_seq (uint8_t* seq_offset, uint16_t seq)
+{
+    *seq_offset = (uint8_t)(seq >> 8);
+    *(seq_offset + 1) = (uint8_t)seq;
+}
+
+/**
+ * @brief read a sequence number in big endian
+ */
+static uint16_t get_sliding_seq (uint8_t* seq_offset)
+{
+    return (uint16_t)(*seq_offset << 8) | *(seq_offset + 1);
+}
+
+void init_sliding_encoder (sliding_encoder_t* encoder, uint8_t window_size, uint16_t symbol_size)
+{
+    gf256_init ();
+    memset (encoder, 0, sizeof (sliding_encoder_t));
+    if (window_size > SW_MAX_WINDOW_SIZE)
+        window_size = SW_MAX_WINDOW_SIZE;
+    if (symbol_size > SW_MAX_SYMBOL_SIZE)
+        symbol_size = SW_MAX_SYMBOL_SIZE;
+    encoder->window_size = window_size;
+    encoder->symbol_size = symbol_size;
+}
+
+bool is_sliding_window_full (sliding_encoder_t* encoder)
+{
+    return get_sliding_window_count (encoder) >= encoder->window_size;
+}
+
+uint8_t get_sliding_window_count (sliding_encoder_t* encoder)
+{
+    return (uint8_t)(uint16_t)(encoder->window_end - encoder->window_start);
+}
+
+uint16_t sliding_encoder_push (sliding_encoder_t* encoder, uint8_t* symbol)
+{
+    uint16_t seq = encoder->window_end;
+    memcpy (encoder->symbols[SW_SLOT (seq)], symbol, encoder->symbol_size);
+    encoder->window_end++;
+    return seq;
+}
+
+void sliding_encoder_ack (sliding_encoder_t* encoder, uint16_t window_edge)
+{
+    // ignore stale or out of range acknowledgements
+    if ((int16_t)(window_edge - encoder->window_start) <= 0 ||
+        (int16_t)(encoder->window_end - window_edge) < 0)
+        return;
+    encoder->window_start = window_edge;
+}
+
+uint16_t produce_sliding_systematic (sliding_encoder_t* encoder, uint16_t seq, uint8_t* packet)
+{
+    *packet = k_sw_systematic_type;
+    set_sliding_seq (packet + 1, seq);
+    memcpy (packet + SW_SYSTEMATIC_HDR_SIZE, encoder->symbols[SW_SLOT (seq)], encoder->symbol_size);
+    return SW_SYSTEMATIC_HDR_SIZE + encoder->symbol_size;
+}
+
+uint16_t produce_sliding_repair (sliding_encoder_t* encoder, uint8_t* packet)
+{
+    uint8_t count = get_sliding_window_count (encoder);
+    uint8_t* coefficients = packet + SW_REPAIR_HDR_SIZE;
+    uint8_t* symbol = coefficients + count;
+    uint16_t seq;
+
+    if (count == 0)
+        return 0;
+    *packet = k_sw_repair_type;
+    set_sliding_seq (packet + 1, encoder->window_start);
+    *(packet + 3) = count;
+    memset (symbol, 0, encoder->symbol_size);
+    for (uint8_t i = 0; i < count; i++)
+    {
+        seq = encoder->window_start + i;
+        // non-zero coefficients, every symbol in the window is covered
+        coefficients[i] = (uint8_t)(rand () % 255 + 1);
+        gf256_mul_add_region (symbol,
+                              encoder->symbols[SW_SLOT (seq)],
+                              coefficients[i],
+                              encoder->symbol_size);
+    }
+    return SW_REPAIR_HDR_SIZE + count + encoder->symbol_size;
+}
+
+void init_sliding_decoder (sliding_decoder_t* decoder, uint16_t symbol_size)
+{
+    gf256_init ();
+    memset (decoder, 0, sizeof (sliding_decoder_t));
+    if (symbol_size > SW_MAX_SYMBOL_SIZE)
+        symbol_size = SW_MAX_SYMBOL_SIZE;
+    decoder->symbol_size = symbol_size;
+}
+
+/**
+ * @brief check if a reduced row holds a single decoded symbol
+ */
+static bool is_sliding_row_decoded (sliding_row_t* row, uint8_t pivot)
+{
+    for (uint8_t i = 0; i < SW_MAX_WINDOW_SIZE; i++)
+        if (i != pivot && row->coefficients[i] != 0)
+            return false;
+    return true;
+}
+
+/**
+ * @brief move decoded symbols at the window edge to the delivery buffer
+ */
+static void sliding_decoder_release (sliding_decoder_t* decoder)
+{
+    uint8_t slot = SW_SLOT (decoder->window_edge);
+    while (decoder->rows[slot].valid == true &&
+           is_sliding_row_decoded (&decoder->rows[slot], slot) == true)
+    {
+        memcpy (decoder->decoded[slot], decoder->rows[slot].symbol, decoder->symbol_size);
+        decoder->decoded_seq[slot] = decoder->window_edge;
+        decoder->decoded_valid[slot] = true;
+        decoder->rows[slot].valid = false;
+        decoder->rank--;
+        decoder->window_edge++;
+        slot = SW_SLOT (decoder->window_edge);
+    }
+}
+
+bool sliding_decoder_consume (sliding_decoder_t* decoder, uint8_t* packet, uint16_t length)
+{
+    static const uint8_t unit_coefficient = 1;
+    uint8_t vector[SW_MAX_WINDOW_SIZE];
+    uint8_t symbol[SW_MAX_SYMBOL_SIZE];
+    uint16_t start;
+    uint8_t count;
+    const uint8_t* coefficients;
+    uint8_t* payload;
+    uint16_t seq;
+    uint8_t slot;
+    uint8_t factor;
+    int16_t pivot = -1;
+
+    // parse packet
+    if (*packet == k_sw_systematic_type && length >= SW_SYSTEMATIC_HDR_SIZE + decoder->symbol_size)
+    {
+        start = get_sliding_seq (packet + 1);
+        count = 1;
+        coefficients = &unit_coefficient;
+        payload = packet + SW_SYSTEMATIC_HDR_SIZE;
+    }
+    else if (*packet == k_sw_repair_type && length >= SW_REPAIR_HDR_SIZE)
+    {
+        start = get_sliding_seq (packet + 1);
+        count = *(packet + 3);
+        coefficients = packet + SW_REPAIR_HDR_SIZE;
+        payload = packet + SW_REPAIR_HDR_SIZE + count;
+        if (length < SW_REPAIR_HDR_SIZE + count + decoder->symbol_size)
+            return false;
+    }
+    else
+        return false;
+
+    // map the coding vector onto the decoder window
+    memset (vector, 0, sizeof vector);
+    memcpy (symbol, payload, decoder->symbol_size);
+    for (uint8_t i = 0; i < count; i++)
+    {
+        seq = start + i;
+        slot = SW_SLOT (seq);
+        if (coefficients[i] == 0)
+            continue;
+        if ((int16_t)(seq - decoder->window_edge) < 0)
+        {
+            // already released, remove its contribution
+            if (decoder->decoded_valid[slot] == false || decoder->decoded_seq[slot] != seq)
+                return false;
+            gf256_mul_add_region (symbol, decoder->decoded[slot], coefficients[i], decoder->symbol_size);
+        }
+        else if ((int16_t)(seq - decoder->window_edge) >= SW_MAX_WINDOW_SIZE)
+            return false;
+        else
+            vector[slot] ^= coefficients[i];
+    }
+
+    // forward elimination in sequence order
+    for (uint8_t offset = 0; offset < SW_MAX_WINDOW_SIZE; offset++)
+    {
+        slot = SW_SLOT (decoder->window_edge + offset);
+        factor = vector[slot];
+        if (factor == 0)
+            continue;
+        if (decoder->rows[slot].valid == true)
+        {
+            gf256_mul_add_region (vector, decoder->rows[slot].coefficients, factor, SW_MAX_WINDOW_SIZE);
+            gf256_mul_add_region (symbol, decoder->rows[slot].symbol, factor, decoder->symbol_size);
+        }
+        else if (pivot < 0)
+            pivot = slot;
+    }
+    // not innovative
+    if (pivot < 0)
+        return false;
+
+    // normalize the new row and reduce the existing rows with it
+    factor = gf256_inv (vector[pivot]);
+    gf256_mul_region (vector, factor, SW_MAX_WINDOW_SIZE);
+    gf256_mul_region (symbol, factor, decoder->symbol_size);
+    for (uint8_t i = 0; i < SW_MAX_WINDOW_SIZE; i++)
+    {
+        factor = decoder->rows[i].coefficients[pivot];
+        if (decoder->rows[i].valid == false || factor == 0)
+            continue;
+        gf256_mul_add_region (decoder->rows[i].coefficients, vector, factor, SW_MAX_WINDOW_SIZE);
+        gf256_mul_add_region (decoder->rows[i].symbol, symbol, factor, decoder->symbol_size);
+    }
+    memcpy (decoder->rows[pivot].coefficients, vector, SW_MAX_WINDOW_SIZE);
+    memcpy (decoder->rows[pivot].symbol, symbol, decoder->symbol_size);
+    decoder->rows[pivot].valid = true;
+    decoder->rank++;
+
+    sliding_decoder_release (decoder);
+    return true;
+}
+
+bool sliding_decoder_read (sliding_decoder_t* decoder, uint8_t* symbol, uint16_t* seq)
+{
+    uint8_t slot;
+    // symbols overwritten before being read are skipped
+    if ((uint16_t)(decoder->window_edge - decoder->read_seq) > SW_MAX_WINDOW_SIZE)
+        decoder->read_seq = decoder->window_edge - SW_MAX_WINDOW_SIZE;
+    if (decoder->read_seq == decoder->window_edge)
+        return false;
+    slot = SW_SLOT (decoder->read_seq);
+    memcpy (symbol, decoder->decoded[slot], decoder->symbol_size);
+    if (seq != NULL)
+        *seq = decoder->read_seq;
+    decoder->read_seq++;
+    return true;
+}
+
+uint16_t get_sliding_window_edge (sliding_decoder_t* decoder)
+{
+    return decoder->window_edge;
+}
@@ -0,0 +1,59 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "sparse_schedule.h"
+
+/*
+   Tunable sparse coding. A receiver of rank r out of g has, roughly, r of
+   the g source symbols pinned down. A coded symbol with w non-zero
+   coefficients at random positions is then useless when every position
+   falls on a known symbol, which happens with probability (r/g)^w.
+   Keeping that below the target dependence e needs
+       w >= ln(e) / ln(r/g)
+   so a few non-zeros are enough early on, and the vector turns dense as
+   the rank approaches g. Sparse vectors are cheaper to encode and keep the
+   decoding matrix sparse, while the last symbols of a generation are not
+   wasted on dependent combinations.
+*/
+
+void init_sparse_schedule (sparse_schedule_t* schedule,
+                           uint16_t generation_size,
+                           uint8_t field_bits,
+                           float dependence)
+{
+    schedule->generation_size = generation_size > 0 ? generation_size : 1;
+    schedule->min_density = 1.0 / schedule->generation_size;
+    schedule->max_density = 1 - pow (2, -(double)field_bits);
+    if (dependence <= 0 || dependence >= 1)
+        dependence = SPARSE_DEFAULT_DEPENDENCE;
+    schedule->dependence = dependence;
+}
+
+float get_sparse_density (sparse_schedule_t* schedule, float rank)
+{
+    float known = rank / schedule->generation_size;
+    float density;
+
+    if (known <= 0)
+        return schedule->min_density;
+    if (known >= 1)
+        return schedule->max_density;
+    density = log (schedule->dependence) / log (known) / schedule->generation_size;
+    if (density < schedule->min_density)
+        return schedule->min_density;
+    if (density > schedule->max_density)
+        return schedule->max_density;
+    return density;
+}
+
+float estimate_remote_rank (uint16_t generation_size,
+                            uint16_t reported_rank,
+                            uint16_t tx_since_report,
+                            float loss)
+{
+    float rank = reported_rank + tx_since_report * (1 - loss);
+    if (rank > generation_size)
+        return generation_size;
+    return rank;
+}
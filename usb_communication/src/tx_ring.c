@@ -0,0 +1,94 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "tx_ring.h"
+
+/*
+   The producer frames and fragments upcoming packets into the tail of the
+   ring while the pacer waits for the next transmit slot. Sending a frame
+   only hands a pointer into the head entry to the serial port. Packets of
+   a generation retired in the meantime are invalidated in place and
+   skipped by the pacer.
+*/
+
+void init_tx_ring (tx_ring_t* ring, uint8_t depth)
+{
+    memset (ring, 0, sizeof (tx_ring_t));
+    if (depth < 1)
+        depth = 1;
+    if (depth > TX_RING_LENGTH)
+        depth = TX_RING_LENGTH;
+    ring->depth = depth;
+}
+
+/**
+ * @brief release invalidated entries at the head of the ring
+ */
+static void tx_ring_skip_invalid (tx_ring_t* ring)
+{
+    while (ring->count > 0 && ring->entries[ring->read_index].valid == false)
+    {
+        ring->read_index = (ring->read_index + 1) % TX_RING_LENGTH;
+        ring->count--;
+        ring->frame_cursor = 0;
+    }
+}
+
+bool is_tx_ring_empty (tx_ring_t* ring)
+{
+    tx_ring_skip_invalid (ring);
+    return ring->count == 0;
+}
+
+bool is_tx_ring_full (tx_ring_t* ring)
+{
+    tx_ring_skip_invalid (ring);
+    return ring->count >= ring->depth;
+}
+
+tx_ring_entry_t* get_tx_ring_tail (tx_ring_t* ring)
+{
+    return &ring->entries[ring->write_index];
+}
+
+void tx_ring_push (tx_ring_t* ring)
+{
+    ring->entries[ring->write_index].valid = true;
+    ring->write_index = (ring->write_index + 1) % TX_RING_LENGTH;
+    ring->count++;
+}
+
+virtual_packet_t* tx_ring_next_frame (tx_ring_t* ring, tx_ring_entry_t** entry, bool* last)
+{
+    virtual_packet_t* frame;
+
+    tx_ring_skip_invalid (ring);
+    if (ring->count == 0)
+        return NULL;
+    *entry = &ring->entries[ring->read_index];
+    frame = &(*entry)->frames[ring->frame_cursor];
+    ring->frame_cursor++;
+    *last = ring->frame_cursor >= (*entry)->frame_num;
+    if (*last == true)
+    {
+        // the frame stays untouched until the producer wraps around to it
+        ring->read_index = (ring->read_index + 1) % TX_RING_LENGTH;
+        ring->count--;
+        ring->frame_cursor = 0;
+    }
+    return frame;
+}
+
+void tx_ring_drop_generation (tx_ring_t* ring, uint8_t generation_id)
+{
+    uint8_t index = ring->read_index;
+    for (uint8_t i = 0; i < ring->count; i++)
+    {
+        // a packet already partly sent is completed
+        if (ring->entries[index].generation_id == generation_id &&
+            (i > 0 || ring->frame_cursor == 0))
+            ring->entries[index].valid = false;
+        index = (index + 1) % TX_RING_LENGTH;
+    }
+}
@@ -0,0 +1,73 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "tx_schedule.h"
+
+/*
+   A schedule maps the n-th packet of a generation to a systematic symbol
+   or to a coded repair symbol. Sending repair symbols between systematic
+   ones repairs a burst before the end of the generation, at the cost of
+   repair symbols that may turn out to be unneeded.
+*/
+
+void build_tx_schedule (tx_schedule_t* schedule,
+                        uint8_t type,
+                        uint16_t interval,
+                        uint16_t generation_size,
+                        uint16_t tx_num)
+{
+    uint16_t systematic_num = 0;
+    uint16_t j;
+    int16_t swap;
+
+    schedule->type = type;
+    schedule->interval = interval > 0 ? interval : 1;
+    if (generation_size > TX_SCHEDULE_LENGTH)
+        generation_size = TX_SCHEDULE_LENGTH;
+    if (tx_num < generation_size)
+        tx_num = generation_size;
+    if (tx_num > TX_SCHEDULE_LENGTH)
+        tx_num = TX_SCHEDULE_LENGTH;
+    for (uint16_t i = 0; i < TX_SCHEDULE_LENGTH; i++)
+    {
+        // a repair slot after every interval systematic slots
+        if (type == SCHEDULE_INTERLEAVED && i % (schedule->interval + 1) == schedule->interval)
+            schedule->order[i] = TX_SCHEDULE_REPAIR;
+        else if (systematic_num < generation_size)
+            schedule->order[i] = systematic_num++;
+        else
+            schedule->order[i] = TX_SCHEDULE_REPAIR;
+    }
+    if (type != SCHEDULE_RANDOM)
+        return;
+    // Fisher-Yates shuffle of the positions within the planned transmissions
+    for (uint16_t i = tx_num - 1; i > 0; i--)
+    {
+        j = rand () % (i + 1);
+        swap = schedule->order[i];
+        schedule->order[i] = schedule->order[j];
+        schedule->order[j] = swap;
+    }
+}
+
+int16_t get_scheduled_symbol (tx_schedule_t* schedule, uint16_t position)
+{
+    if (position >= TX_SCHEDULE_LENGTH)
+        return TX_SCHEDULE_REPAIR;
+    return schedule->order[position];
+}
+
+const char* get_tx_schedule_name (uint8_t type)
+{
+    switch (type)
+    {
+        case SCHEDULE_INTERLEAVED:
+            return "interleaved";
+        case SCHEDULE_RANDOM:
+            return "random";
+        default:
+            return "sequential";
+    }
+}
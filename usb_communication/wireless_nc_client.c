@@ -13,6 +13,16 @@
 #include "utils.h"
 #include "lowpan.h"
 #include "reassemble.h"
+#include "fec.h"
+#include "coding_vector.h"
+#include "nc_header.h"
+#include "nc_field.h"
+#include "redundancy.h"
+#include "tx_ring.h"
+#include "file_map.h"
+#include "tx_schedule.h"
+#include "autotune.h"
+#include "sparse_schedule.h"
 #include "config.h"
 
 #include <kodo_rlnc/coders.hpp>
@@ -28,13 +38,32 @@ static struct option long_options[] =
     {"redundancy",  required_argument, 0, 'r'},
     {"density",     no_argument,       0, 'd'},
     {"recode",      no_argument,       0, 'c'},
+    {"address",     required_argument, 0, 'a'},
+    {"meshDest",    required_argument, 0, 'm'},
+    {"fecParity",   required_argument, 0, 'e'},
+    {"generations", required_argument, 0, 'n'},
+    {"pipeline",    required_argument, 0, 'k'},
+    {"seed",        no_argument,       0, 'v'},
+    {"blockSize",   required_argument, 0, 'b'},
+    {"feedback",    no_argument,       0, 'f'},
+    {"target",      required_argument, 0, 'q'},
+    {"rateless",    no_argument,       0, 'u'},
+    {"ring",        required_argument, 0, 'w'},
+    {"batch",       required_argument, 0, 'x'},
+    {"input",       required_argument, 0, 'i'},
+    {"interleave",  required_argument, 0, 'j'},
+    {"shuffle",     no_argument,       0, 'y'},
+    {"autotune",    required_argument, 0, 't'},
+    {"field",       required_argument, 0, 'F'},
+    {"tunable",     required_argument, 0, 'z'},
+    {"flow",        required_argument, 0, 'S'},
     {"help",        no_argument,       0, 'h'},
     {0, 0, 0, 0}
 };
 
 void usage(void)
 {
-    printf ("Usage: [-p --port <serial port number>] [-s --symbolSize <symbol size>] [-g --genSize <generation size>] [-r --redundancy <redundancy in percent>] [-d --density] [-c --recode] [-h --help]\n");
+    printf ("Usage: [-p --port <serial port number>] [-s --symbolSize <symbol size>] [-g --genSize <generation size>] [-r --redundancy <redundancy in percent>] [-d --density] [-c --recode] [-a --address <mesh short address>] [-m --meshDest <mesh final destination>] [-e --fecParity <parity fragments>] [-n --generations <generations>] [-k --pipeline <generations in flight>] [-v --seed] [-b --blockSize <data bytes per generation>] [-f --feedback] [-q --target <decode probability in percent>] [-u --rateless] [-w --ring <precomputed packets>] [-x --batch <payloads per batch>] [-i --input <file or - for stdin>] [-j --interleave <systematic symbols per repair>] [-y --shuffle] [-t --autotune <loss in percent>] [-F --field <finite field>] [-z --tunable <non-innovative percent>] [-S --flow <flow id>] [-h --help]\n");
     printf ("Options:\n");
     printf ("\t-p --port\tserial port number to open\tDefault: /dev/ttyACM0\n");
     printf ("\t-s --symbolSize\tsymbol size\t\t\tDefault: 4\n");
@@ -42,20 +71,122 @@ void usage(void)
     printf ("\t-r --redundancy\tredundancy in percent\t\tDefault: 20\n");
     printf ("\t-d --density\tenable sparse coding\n");
     printf ("\t-c --recode\tenable recoding\n");
+    printf ("\t-a --address\tmesh originator address\t\tDefault: 10\n");
+    printf ("\t-m --meshDest\tsend frames with a mesh header to this address\n");
+    printf ("\t-e --fecParity\tparity fragments per fragmented packet\tDefault: 0\n");
+    printf ("\t-n --generations\tgenerations to transfer\tDefault: 1\n");
+    printf ("\t-k --pipeline\tgenerations in flight at once\tDefault: 1\n");
+    printf ("\t-v --seed\tsend a seed instead of the coding vector\n");
+    printf ("\t-b --blockSize\tdata bytes per generation, the last symbol is sent short\tDefault: full generation\n");
+    printf ("\t-f --feedback\tadapt redundancy to the loss reported by the server\n");
+    printf ("\t-q --target\ttarget decode probability in percent\tDefault: 99\n");
+    printf ("\t-u --rateless\tsend until decoded, resend the rank deficit reported by the server\n");
+    printf ("\t-w --ring\tpackets precomputed ahead of the pacer\tDefault: 4\n");
+    printf ("\t-x --batch\tproduce kodo payloads in batches of this size\tDefault: 0 (symbol API)\n");
+    printf ("\t-i --input\ttransfer a file or stdin, overrides the generation number\n");
+    printf ("\t-j --interleave\tsend a repair symbol after every n systematic ones\tDefault: 0 (repair after all systematic)\n");
+    printf ("\t-y --shuffle\tsend systematic and repair symbols in random order\n");
+    printf ("\t-t --autotune\tchoose symbol size, generation size and redundancy for this loss, overrides -s -g -r\n");
+    printf ("\t-F --field\tbinary, binary4, binary8, binary16 or prime2325, the relay and server must match\tDefault: binary8\n");
+    printf ("\t-z --tunable\tsparse coding with a density that rises with the rank reported by the server, a coded symbol is non-innovative with at most this probability\n");
+    printf ("\t-S --flow\tflow id, lets a relay keep the generations of several sources apart\tDefault: 85\n");
     printf ("\t-h --help\tthis help documetation\n");
 }
 
+typedef struct
+{
+    kodo_rlnc::encoder* encoder;
+    uint8_t* data_in;           // owned source buffer, unused when the input file is the storage
+    uint32_t block_length;      // source bytes of the generation
+    uint8_t generation_id;
+    uint16_t tx_packet_count;   // packets produced
+    uint16_t tx_sent_count;     // packets written to the serial port
+    uint16_t tx_limit;      // end of the current rateless round
+    uint64_t round_end_time;    // us, wall clock since the pacer sleeps
+    uint8_t* payload_data;      // pre-allocated payloads of the batch payload API
+    uint8_t** payloads;
+    uint16_t payload_cursor;    // next payload of the batch to send
+    uint16_t payload_num;       // payloads produced in the batch
+    tx_schedule_t schedule;     // order of systematic and repair symbols
+    uint16_t remote_rank;       // last rank reported by the server
+    uint16_t report_tx_count;   // packets sent when the rank was reported
+    bool active;
+} encoder_slot_t;
+
+/**
+ * @brief reset an encoder slot and load the source data of a new generation,
+ *        from the input file if there is one
+ */
+void load_generation (encoder_slot_t* slot,
+                      uint16_t generation,
+                      uint32_t block_length,
+                      bool sparse_enable,
+                      file_map_t* input,
+                      uint16_t tx_num)
+{
+    slot->encoder->reset ();
+    // enable sparse coding
+    if (sparse_enable == true)
+        slot->encoder->set_density (0.5);
+    // a sparse payload carries its density, reset falls back to the seed format
+    if (sparse_enable == true && slot->payloads != NULL)
+        slot->encoder->set_coding_vector_format (kodo_rlnc::coding_vector_format::sparse_seed);
+    slot->payload_cursor = 0;
+    slot->payload_num = 0;
+    if (input != NULL)
+    {
+        slot->block_length = get_file_block_length (input, generation, block_length);
+        // a full block is encoded straight from the file mapping
+        if (slot->block_length == slot->encoder->block_size())
+            slot->encoder->set_symbols_storage (input->data + (uint64_t)generation * block_length);
+        else
+        {
+            // a short block is copied and zero padded, the mapping may end before a full block
+            memset (slot->data_in, 0, slot->encoder->block_size());
+            memcpy (slot->data_in, input->data + (uint64_t)generation * block_length, slot->block_length);
+            slot->encoder->set_symbols_storage (slot->data_in);
+        }
+    }
+    else
+    {
+        slot->block_length = block_length;
+        // fill source data buffer with generation specific values,
+        // the tail of a short block is zero padded
+        memset (slot->data_in, 0, slot->encoder->block_size());
+        memset (slot->data_in, 'T' + generation % 6, block_length);
+        // assign source data buffer to encoder
+        slot->encoder->set_symbols_storage (slot->data_in);
+    }
+    build_tx_schedule (&slot->schedule,
+                       slot->schedule.type,
+                       slot->schedule.interval,
+                       slot->encoder->symbols(),
+                       tx_num);
+    slot->generation_id = (uint8_t)generation;
+    slot->tx_packet_count = 0;
+    slot->tx_sent_count = 0;
+    slot->remote_rank = 0;
+    slot->report_tx_count = 0;
+    // the first rateless round is the systematic phase
+    slot->tx_limit = slot->encoder->symbols();
+    slot->active = true;
+}
+
 void print_nc_config (kodo_rlnc::encoder* encoder,
                       float redundancy,
-                      uint16_t total_tx_num)
+                      uint16_t total_tx_num,
+                      tx_schedule_t* schedule,
+                      uint8_t field_id)
 {
     // print configuration
     printf ("---------NC configuration---------\n");
+    printf ("finite field:\t\t\t%s\n", get_field_name (field_id));
     printf ("encoder symbol size:\t\t%u\n", encoder->symbol_size());
     printf ("encoder coeff vector size:\t%u\n", encoder->coefficient_vector_size());
     printf ("encoder payload size:\t\t%u\n", encoder->max_payload_size());
     printf ("redundancy ratio:\t\t%.2f\n", redundancy);
     printf ("total tx packets:\t\t%u\n", total_tx_num);
+    printf ("transmit schedule:\t\t%s\n", get_tx_schedule_name (schedule->type));
     printf ("---------NC configuration---------\n");
 }
 
@@ -68,12 +199,34 @@ int main(int argc, char *argv[])
     float redundancy = 0.2;
     bool sparse_enable = false;
     bool recode_enable = false;
+    bool mesh_enable = false;
+    uint16_t mesh_address = 10;
+    uint16_t mesh_destination = 0;
+    uint8_t fec_parity_num = 0;
+    uint16_t generation_num = 1;
+    uint32_t pipeline_size = 1;
+    bool seed_enable = false;
+    uint32_t block_length = 0;
+    bool feedback_enable = false;
+    float target = 0.99;
+    bool rateless_enable = false;
+    uint8_t ring_depth = 4;
+    uint16_t batch_size = 0;
+    char* input_file_name = NULL;
+    uint8_t schedule_type = SCHEDULE_SEQUENTIAL;
+    uint16_t schedule_interval = 0;
+    bool autotune_enable = false;
+    float autotune_loss = 0;
+    uint8_t field_id = NC_FIELD_DEFAULT;
+    bool tunable_enable = false;
+    float tunable_dependence = SPARSE_DEFAULT_DEPENDENCE;
+    uint8_t flow_id = 'U'; // source port byte of a plain UDPHC header
 
     // cmd arguments parsing
     int opt;
     int option_index = 0;
 
-    while ((opt = getopt_long (argc, argv, "p:s:g:r:dch", long_options, &option_index)) != -1)
+    while ((opt = getopt_long (argc, argv, "p:s:g:r:dca:m:e:n:k:vb:fq:uw:x:i:j:yt:F:z:S:h", long_options, &option_index)) != -1)
     {
         switch (opt)
         {
@@ -95,6 +248,74 @@ int main(int argc, char *argv[])
             case 'c':
                 recode_enable = true;
                 break;
+            case 'a':
+                mesh_address = atoi (optarg);
+                break;
+            case 'm':
+                mesh_enable = true;
+                mesh_destination = atoi (optarg);
+                break;
+            case 'e':
+                fec_parity_num = atoi (optarg);
+                break;
+            case 'n':
+                generation_num = atoi (optarg);
+                break;
+            case 'k':
+                pipeline_size = atoi (optarg);
+                break;
+            case 'v':
+                seed_enable = true;
+                break;
+            case 'b':
+                block_length = atoi (optarg);
+                break;
+            case 'f':
+                feedback_enable = true;
+                break;
+            case 'q':
+                target = (float)atoi (optarg) / 100;
+                break;
+            case 'u':
+                rateless_enable = true;
+                break;
+            case 'w':
+                ring_depth = atoi (optarg);
+                break;
+            case 'x':
+                batch_size = atoi (optarg);
+                break;
+            case 'i':
+                input_file_name = optarg;
+                break;
+            case 'j':
+                schedule_interval = atoi (optarg);
+                if (schedule_interval > 0 && schedule_type == SCHEDULE_SEQUENTIAL)
+                    schedule_type = SCHEDULE_INTERLEAVED;
+                break;
+            case 'y':
+                schedule_type = SCHEDULE_RANDOM;
+                break;
+            case 't':
+                autotune_enable = true;
+                autotune_loss = (float)atoi (optarg) / 100;
+                break;
+            case 'F':
+                if (parse_field_name (optarg, &field_id) == false)
+                {
+                    fprintf (stderr, "unknown finite field %s\n", optarg);
+                    return -1;
+                }
+                break;
+            case 'z':
+                // tunable sparse coding is a sparse mode
+                sparse_enable = true;
+                tunable_enable = true;
+                tunable_dependence = (float)atoi (optarg) / 100;
+                break;
+            case 'S':
+                flow_id = atoi (optarg);
+                break;
             case 'h':
                 usage ();
                 return 0;
@@ -107,6 +328,49 @@ int main(int argc, char *argv[])
     // Seed random number generator to produce different results every time
     srand (static_cast<uint32_t> (time (0)));
 
+    // the input file is mapped first, its size is an input of the autotuner
+    file_map_t input_map;
+    file_map_t* input = NULL;
+    if (input_file_name != NULL)
+    {
+        if (map_input_file (&input_map, input_file_name) < 0)
+            return -1;
+        if (input_map.size == 0)
+        {
+            fprintf (stderr, "nothing to send in %s\n", input_file_name);
+            return -1;
+        }
+        input = &input_map;
+    }
+
+    // fill frames without fragmentation
+    autotune_input_t autotune_input;
+    autotune_result_t autotune_result;
+    if (autotune_enable == true)
+    {
+        memset (&autotune_input, 0, sizeof autotune_input);
+        autotune_input.payload_size = input != NULL ? input->size : 0;
+        autotune_input.field_bits = get_field_bits (field_id);
+        autotune_input.vector_format = seed_enable == true ? AUTOTUNE_SEED_VECTOR : AUTOTUNE_FULL_VECTOR;
+        autotune_input.extra_header_size = mesh_enable == true ? MESH_HDR_SIZE : 0;
+        autotune_input.loss = autotune_loss;
+        autotune_input.target = target;
+        autotune_input.max_generation_size = AUTOTUNE_DEFAULT_MAX_GEN_SIZE;
+        if (autotune_coding (&autotune_input, &autotune_result) == false)
+        {
+            fprintf (stderr, "no configuration reaches the target without fragmentation\n");
+            return -1;
+        }
+        symbol_size = autotune_result.symbol_size;
+        generation_size = autotune_result.generation_size;
+        redundancy = (float)(autotune_result.tx_num - generation_size) / generation_size;
+        printf ("autotune: symbol size %u, generation size %u, %u packets per generation, goodput %.2f bytes/frame\n",
+                symbol_size,
+                generation_size,
+                autotune_result.tx_num,
+                autotune_result.goodput);
+    }
+
     // USB communication
     int fd = open_serial_port (serial_port, B115200, 0);
     if (fd < 0)
@@ -115,11 +379,18 @@ int main(int argc, char *argv[])
         return -1;
     }
 
+    if (pipeline_size < 1)
+        pipeline_size = 1;
+    if (pipeline_size > MAX_PIPELINE_SIZE)
+        pipeline_size = MAX_PIPELINE_SIZE;
+
     // variable definitions
     uint32_t inter_frame_interval = 30000; // inter frame interval in us
     int ret;
+    int rx_num = 0;
     uint8_t rx_buf[MAX_SIZE];
     memset (rx_buf, 0, sizeof rx_buf);
+    control_frame_t control;
     uint16_t tx_frame_count = 0;
     uint16_t tx_packet_count = 0;
     uint16_t total_tx_num = 0;
@@ -127,130 +398,398 @@ int main(int argc, char *argv[])
         total_tx_num = generation_size * (1 + redundancy);
     else
         total_tx_num = generation_size * (1 + redundancy / 2);
+    // the tuned packet count is exact, float redundancy may round it down
+    if (autotune_enable == true && recode_enable == false)
+        total_tx_num = autotune_result.tx_num;
+    // closed loop redundancy, the loss rate -r is sized for is the starting estimate
+    loss_estimator_t loss_estimator;
+    init_loss_estimator (&loss_estimator, LOSS_EWMA_ALPHA, redundancy / (1 + redundancy));
+    uint16_t max_tx_num = generation_size * 4;
+    // rateless generations run until decoded, a generation is given up at max_tx_num
+    uint32_t round_timeout = 300; // ms, hard coded
+    if (rateless_enable == true)
+        total_tx_num = max_tx_num;
     // time related variables
-    struct timeval send_start, send_end;
-    memset (&send_start, 0, sizeof send_start);
-    memset (&send_end, 0, sizeof send_end);
-    uint64_t total_time_used = 0; // us
+    struct timeval produce_start, produce_end, now;
+    memset (&produce_start, 0, sizeof produce_start);
+    memset (&produce_end, 0, sizeof produce_end);
+    uint64_t total_time_used = 0; // us spent producing packets
+    uint64_t next_send_time = 0; // us
+    uint64_t now_time = 0; // us
 
     // encoder initialization
     // set finite field size
-    fifi::finite_field field = fifi::finite_field::binary8;
-    // create an encoder
-    kodo_rlnc::encoder encoder (field, generation_size, symbol_size);
-
-    // enable sparse coding
-    if (sparse_enable == true)
-        encoder.set_density (0.5);
+    fifi::finite_field field = (fifi::finite_field)field_id;
+    // create an encoder pool, encoders are reset instead of rebuilt for every generation
+    encoder_slot_t encoder_pool[pipeline_size];
+    memset (encoder_pool, 0, sizeof encoder_pool);
+    uint32_t payload_size = 0;
+    for (uint8_t k = 0; k < pipeline_size; k++)
+    {
+        encoder_pool[k].encoder = new kodo_rlnc::encoder (field, generation_size, symbol_size);
+        encoder_pool[k].data_in = new uint8_t[encoder_pool[k].encoder->block_size()];
+        encoder_pool[k].schedule.type = schedule_type;
+        encoder_pool[k].schedule.interval = schedule_interval;
+        if (batch_size == 0)
+            continue;
+        // a sparse seed payload is the largest payload format
+        encoder_pool[k].encoder->set_coding_vector_format (kodo_rlnc::coding_vector_format::sparse_seed);
+        payload_size = encoder_pool[k].encoder->max_payload_size();
+        encoder_pool[k].payload_data = new uint8_t[batch_size * payload_size];
+        encoder_pool[k].payloads = new uint8_t*[batch_size];
+        for (uint16_t i = 0; i < batch_size; i++)
+            encoder_pool[k].payloads[i] = encoder_pool[k].payload_data + i * payload_size;
+    }
+    kodo_rlnc::encoder* encoder = encoder_pool[0].encoder;
+    encoder_slot_t* slot = NULL;
+    uint16_t next_generation = 0;
+    uint16_t retired_generation_num = 0;
+    uint8_t slot_cursor = 0;
+    // seed encoded coding vectors replace the full vector on the wire
+    float density = sparse_enable == true ? 0.5 : 1;
+    float density_total = 0;
+    uint16_t coded_count = 0;
+    sparse_schedule_t sparse_schedule;
+    init_sparse_schedule (&sparse_schedule, generation_size, get_field_bits (field_id), tunable_dependence);
+    uint16_t seed = (uint16_t)rand ();
+    if (block_length == 0 || block_length > encoder->block_size())
+        block_length = encoder->block_size();
+    if (block_length <= (generation_size - 1) * symbol_size)
+    {
+        fprintf (stderr, "block size %u leaves the last symbol empty\n", block_length);
+        return -1;
+    }
+    // file transfer, the file is split into blocks of one generation each
+    if (input != NULL)
+    {
+        if (get_file_block_num (input, block_length) > UINT16_MAX)
+        {
+            fprintf (stderr, "%s needs more than %u generations\n", input_file_name, UINT16_MAX);
+            return -1;
+        }
+        generation_num = get_file_block_num (input, block_length);
+        printf ("input %s: %llu bytes in %u generations\n",
+                input_file_name,
+                (unsigned long long)input->size,
+                generation_num);
+    }
+    nc_header_t header;
+    memset (&header, 0, sizeof header);
+    int16_t symbol_index = 0;
 
     // set buffers
-    uint8_t encoder_symbol[encoder.symbol_size()];
-    uint8_t encoder_symbol_coefficients[encoder.coefficient_vector_size()];
-    uint8_t data_in[encoder.block_size()];
+    uint8_t encoder_symbol[encoder->symbol_size()];
+    uint8_t encoder_symbol_coefficients[encoder->coefficient_vector_size()];
     memset (encoder_symbol, 0, sizeof encoder_symbol);
     memset (encoder_symbol_coefficients, 0, sizeof encoder_symbol_coefficients);
-    // fill source data buffer with specific values
-    memset (data_in, 'T', sizeof (data_in));
-
-    // set ack packet buffer
-    uint8_t ack_packet[MAX_SIZE];
-    memset (ack_packet, 0, sizeof ack_packet);
-
-    // assign source data buffer to encoder
-    encoder.set_symbols_storage (data_in);
 
     // set data packet buffer
     uint32_t tx_packet_length = 0;
-    uint8_t packet[encoder.symbol_size() +
-                   encoder.coefficient_vector_size() +
+    uint8_t packet[encoder->symbol_size() +
+                   get_nc_max_header_size (encoder->coefficient_vector_size()) +
+                   payload_size +
                    IPHC_TOTAL_SIZE +
                    UDPHC_TOTAL_SIZE];
     memset (packet, 0, sizeof packet);
-    virtual_packet_t tx_packet[MAX_FRAG_NUM];
-    memset (tx_packet, 0, sizeof (virtual_packet_t) * MAX_FRAG_NUM);
+    uint8_t* nc_payload = packet + IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE;
+    // precomputed packets, the pacer only hands frames to the serial port
+    static tx_ring_t tx_ring;
+    init_tx_ring (&tx_ring, ring_depth);
+    tx_ring_entry_t* entry = NULL;
+    virtual_packet_t* frame = NULL;
+    bool last_frame = false;
+
+    print_nc_config (encoder, redundancy, total_tx_num, &encoder_pool[0].schedule, field_id);
 
-    print_nc_config (&encoder, redundancy, total_tx_num);
+    // load the first generations into the pipeline
+    for (uint8_t k = 0; k < pipeline_size && next_generation < generation_num; k++)
+    {
+        load_generation (&encoder_pool[k], next_generation, block_length, sparse_enable, input,
+                         rateless_enable == true ? generation_size : total_tx_num);
+        next_generation++;
+    }
 
     // client operations
-    while (tx_packet_count < total_tx_num)
+    while (retired_generation_num < generation_num || is_tx_ring_empty (&tx_ring) == false)
     {
-        if (tx_packet_count < generation_size) // systematic phase
+        // server feedback of a generation in flight
+        rx_num = read_serial_port (fd, rx_buf, NULL, false);
+        if (rx_num > 0 &&
+            parse_control_frame (rx_buf, rx_num, &control) == true &&
+            control.type == CONTROL_GENERATION_ACK)
+            // queued packets of a decoded generation are never sent
+            tx_ring_drop_generation (&tx_ring, control.sequence);
+        if (rx_num > 0 && parse_control_frame (rx_buf, rx_num, &control) == true)
+            for (uint8_t k = 0; k < pipeline_size; k++)
+            {
+                slot = &encoder_pool[k];
+                if (slot->active == false || slot->generation_id != control.sequence)
+                    continue;
+                // the tunable sparse schedule counts packets from the last report on
+                if (control.type == CONTROL_RANK_REPORT)
+                {
+                    slot->remote_rank = control.option >> 8;
+                    slot->report_tx_count = slot->tx_sent_count;
+                }
+                if (control.type == CONTROL_GENERATION_ACK)
+                {
+                    // retire generations already decoded by the server
+                    printf ("[client] generation %u decoded by server\n", control.sequence);
+                    slot->tx_packet_count = total_tx_num;
+                }
+                // rank report, option is rank (high byte) and received packets (low byte)
+                else if (control.type == CONTROL_RANK_REPORT &&
+                         rateless_enable == true &&
+                         slot->tx_packet_count >= slot->tx_limit &&
+                         (control.option >> 8) < generation_size)
+                {
+                    // next round sends exactly the rank deficit
+                    slot->tx_limit = slot->tx_packet_count + generation_size - (control.option >> 8);
+                    printf ("[client] generation %u rank deficit %u\n",
+                            control.sequence,
+                            generation_size - (control.option >> 8));
+                }
+                // the received count saturates at 255, later reports give no loss sample
+                else if (control.type == CONTROL_RANK_REPORT &&
+                         rateless_enable == false &&
+                         feedback_enable == true &&
+                         slot->tx_sent_count <= 255)
+                {
+                    update_loss_estimator (&loss_estimator,
+                                           slot->tx_sent_count,
+                                           (uint8_t)control.option);
+                    total_tx_num = get_adaptive_tx_num (generation_size,
+                                                        loss_estimator.loss,
+                                                        target,
+                                                        max_tx_num);
+                    printf ("[client] generation %u rank %u, estimated loss %.2f, tx packets %u\n",
+                            control.sequence,
+                            control.option >> 8,
+                            loss_estimator.loss,
+                            total_tx_num);
+                }
+            }
+        memset (rx_buf, 0, sizeof rx_buf);
+
+        // refill slots of retired generations
+        for (uint8_t k = 0; k < pipeline_size; k++)
         {
-            // generate systematic symbol
-            encoder.produce_systematic_symbol (encoder_symbol, tx_packet_count);
-            // construct packet
-            set_ip_header (packet);
-            set_udp_header (packet + IPHC_TOTAL_SIZE);
-            // set index of systematic packet
-            *(packet + IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE) = (uint8_t)tx_packet_count;
-            memcpy (packet + IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE + sizeof (uint8_t),
-                    encoder_symbol,
-                    sizeof encoder_symbol);
-            tx_packet_length = IPHC_TOTAL_SIZE +
-                               UDPHC_TOTAL_SIZE +
-                               sizeof (uint8_t) +
-                               sizeof encoder_symbol;
+            slot = &encoder_pool[k];
+            if (slot->active == false || slot->tx_packet_count < total_tx_num)
+                continue;
+            slot->active = false;
+            retired_generation_num++;
+            if (next_generation >= generation_num)
+                continue;
+            load_generation (slot, next_generation, block_length, sparse_enable, input,
+                             rateless_enable == true ? generation_size : total_tx_num);
+            next_generation++;
+        }
+
+        // a rateless round without report lost its last packet or the report,
+        // probe with one more packet
+        gettimeofday (&now, NULL);
+        now_time = 1000000 * (uint64_t)now.tv_sec + now.tv_usec;
+        for (uint8_t k = 0; k < pipeline_size && rateless_enable == true; k++)
+        {
+            slot = &encoder_pool[k];
+            if (slot->active == true &&
+                slot->tx_sent_count >= slot->tx_limit &&
+                now_time - slot->round_end_time > (uint64_t)round_timeout * 1000)
+                slot->tx_limit = slot->tx_packet_count + 1;
+        }
+
+        // interleave the generations in flight, nothing is produced while the ring is full
+        slot = NULL;
+        for (uint8_t k = 0; k < pipeline_size && is_tx_ring_full (&tx_ring) == false; k++)
+        {
+            slot_cursor = (slot_cursor + 1) % pipeline_size;
+            if (encoder_pool[slot_cursor].active == true &&
+                (rateless_enable == false ||
+                 encoder_pool[slot_cursor].tx_packet_count < encoder_pool[slot_cursor].tx_limit))
+            {
+                slot = &encoder_pool[slot_cursor];
+                break;
+            }
         }
-        else // coding phase
+        // producer, precompute the next packet while the pacer waits
+        if (slot != NULL)
         {
-            // generate coding coefficients for an encoded packet
-            encoder.generate (encoder_symbol_coefficients);
-            // write encoded symbol corresponding to the coding coefficients
-            encoder.produce_symbol (encoder_symbol,
-                                    encoder_symbol_coefficients);
+            gettimeofday (&produce_start, NULL);
+            encoder = slot->encoder;
+
             // construct packet
             set_ip_header (packet);
             set_udp_header (packet + IPHC_TOTAL_SIZE);
-            memcpy (packet + IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE,
-                    encoder_symbol_coefficients,
-                    sizeof encoder_symbol_coefficients);
-            memcpy (packet + IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE +
-                    sizeof encoder_symbol_coefficients,
-                    encoder_symbol,
-                    sizeof encoder_symbol);
+            set_udp_flow (packet + IPHC_TOTAL_SIZE, flow_id);
+            header.generation_id = slot->generation_id;
+            header.field = field_id;
+            // the last packet of a rateless round asks the server for its rank deficit
+            header.flags = 0;
+            if (rateless_enable == true && slot->tx_packet_count + 1 == slot->tx_limit)
+                header.flags = NC_FLAG_ROUND_END;
+            header.symbol = encoder_symbol;
+            header.length = sizeof encoder_symbol;
+            // tunable sparse coding, density follows the estimated rank of the server
+            if (tunable_enable == true)
+            {
+                density = get_sparse_density (&sparse_schedule,
+                                              estimate_remote_rank (generation_size,
+                                                                    slot->remote_rank,
+                                                                    slot->tx_packet_count - slot->report_tx_count,
+                                                                    loss_estimator.loss));
+                encoder->set_density (density);
+            }
+            if (batch_size > 0) // batch payload API
+            {
+                // refill the batch once all of its payloads are sent
+                if (slot->payload_cursor >= slot->payload_num)
+                {
+                    slot->payload_num = encoder->produce_payloads (slot->payloads, batch_size);
+                    slot->payload_cursor = 0;
+                }
+                // payload sizes are not returned by a batch, every payload takes the maximum size
+                header.type = NC_PAYLOAD;
+                header.symbol = slot->payloads[slot->payload_cursor];
+                header.length = encoder->max_payload_size();
+                slot->payload_cursor++;
+            }
+            else if (get_scheduled_symbol (&slot->schedule, slot->tx_packet_count) != TX_SCHEDULE_REPAIR) // systematic
+            {
+                symbol_index = get_scheduled_symbol (&slot->schedule, slot->tx_packet_count);
+                // generate systematic symbol
+                encoder->produce_systematic_symbol (encoder_symbol, symbol_index);
+                header.type = NC_SYSTEMATIC;
+                header.index = (uint8_t)symbol_index;
+                // the last source symbols only carry the rest of the block
+                header.length = get_block_symbol_length (slot->block_length,
+                                                         symbol_index,
+                                                         symbol_size);
+            }
+            else if (seed_enable == true) // coding phase with seed encoded coding vector
+            {
+                generate_seeded_coefficients (encoder_symbol_coefficients, generation_size, seed, density, field_id);
+                encoder->produce_symbol (encoder_symbol,
+                                         encoder_symbol_coefficients);
+                header.type = NC_SEEDED;
+                header.seed = seed;
+                header.density = density;
+                seed++;
+                density_total += density;
+                coded_count++;
+            }
+            else // coding phase
+            {
+                // generate coding coefficients for an encoded packet
+                encoder->generate (encoder_symbol_coefficients);
+                // write encoded symbol corresponding to the coding coefficients
+                encoder->produce_symbol (encoder_symbol,
+                                         encoder_symbol_coefficients);
+                header.type = NC_CODED;
+                header.coefficients = encoder_symbol_coefficients;
+                header.coefficient_size = sizeof encoder_symbol_coefficients;
+                density_total += encoder->density();
+                coded_count++;
+            }
             tx_packet_length = IPHC_TOTAL_SIZE +
                                UDPHC_TOTAL_SIZE +
-                               sizeof encoder_symbol_coefficients +
-                               sizeof encoder_symbol;
-        }
+                               write_nc_packet (nc_payload, &header);
+            slot->tx_packet_count++;
 
-        // mark start time
-        gettimeofday (&send_start, NULL);
-
-        // fragmentation
-        if (need_fragmentation (tx_packet_length) == true)
-        {
-            printf ("[client] lowpan fragmentation needed\n");
-            do_fragmentation (tx_packet, packet, tx_packet_length);
-            for (uint8_t j = 0; j < get_fragment_num(); j++)
+            // frame and fragment into the ring
+            entry = get_tx_ring_tail (&tx_ring);
+            entry->generation_id = slot->generation_id;
+            entry->flags = header.flags;
+            if (need_fragmentation (tx_packet_length + (mesh_enable ? MESH_HDR_SIZE : 0)) == true)
             {
-                ret = write_serial_port (fd, tx_packet[j].packet, tx_packet[j].length);
-                if (ret < 0)
+                if (fec_parity_num > 0)
+                    entry->frame_num = do_fec_fragmentation (entry->frames, packet, tx_packet_length, fec_parity_num);
+                else
+                {
+                    do_fragmentation (entry->frames, packet, tx_packet_length);
+                    entry->frame_num = get_fragment_num();
+                }
+            }
+            else
+            {
+                generate_normal_packet (&entry->frames[0], packet, tx_packet_length);
+                entry->frame_num = 1;
+            }
+            // the fragmentation decision leaves room for the mesh header, a frame
+            // without it would not be routed, so it is never sent
+            for (uint8_t j = 0; j < entry->frame_num && mesh_enable == true; j++)
+            {
+                if (add_mesh_header (&entry->frames[j], mesh_address, mesh_destination, MESH_MAX_HOPS_LEFT) == 0)
+                {
+                    fprintf (stderr, "frame of %u bytes has no room for the mesh header\n", entry->frames[j].length);
                     return -1;
-                printf ("[client] send a frame\n");
-                tx_frame_count++;
-                usleep (inter_frame_interval);
+                }
             }
-            tx_packet_count++;
+            tx_ring_push (&tx_ring);
+
+            gettimeofday (&produce_end, NULL);
+            total_time_used += 1000000 * (produce_end.tv_sec - produce_start.tv_sec) +
+                               produce_end.tv_usec - produce_start.tv_usec;
         }
-        else
+
+        // pacer, send one frame per inter frame interval
+        gettimeofday (&now, NULL);
+        now_time = 1000000 * (uint64_t)now.tv_sec + now.tv_usec;
+        if (now_time < next_send_time)
         {
-            generate_normal_packet (&tx_packet[0], packet, tx_packet_length);
-            ret = write_serial_port (fd, tx_packet[0].packet, tx_packet[0].length);
-            if (ret < 0)
-                return -1;
-            printf ("[client] send a packet\n");
-            tx_frame_count++;
-            tx_packet_count++;
-            usleep (inter_frame_interval);
+            // keep producing until the ring is full, then sleep until the next slot
+            if (slot == NULL)
+                usleep (next_send_time - now_time < 1000 ? next_send_time - now_time : 1000);
+            continue;
+        }
+        frame = tx_ring_next_frame (&tx_ring, &entry, &last_frame);
+        if (frame == NULL)
+        {
+            // every generation waits for feedback
+            if (slot == NULL)
+                usleep (1000);
+            continue;
+        }
+        ret = write_serial_port (fd, frame->packet, frame->length);
+        if (ret < 0)
+            return -1;
+        tx_frame_count++;
+        next_send_time = now_time + inter_frame_interval;
+        if (last_frame == false)
+        {
+            printf ("[client] send a frame\n");
+            continue;
+        }
+        printf ("[client] send a packet of generation %u\n", entry->generation_id);
+        tx_packet_count++;
+        for (uint8_t k = 0; k < pipeline_size; k++)
+        {
+            slot = &encoder_pool[k];
+            if (slot->active == false || slot->generation_id != entry->generation_id)
+                continue;
+            slot->tx_sent_count++;
+            // the rateless round timeout starts once its last packet is on air
+            if ((entry->flags & NC_FLAG_ROUND_END) != 0)
+                slot->round_end_time = now_time;
         }
-
-        // mark end time
-        gettimeofday (&send_end, NULL);
-        total_time_used += 1000000 * (send_end.tv_sec - send_start.tv_sec) +
-                           send_end.tv_usec - send_start.tv_usec;
     } // end of while
+    for (uint8_t k = 0; k < pipeline_size; k++)
+    {
+        delete encoder_pool[k].encoder;
+        delete[] encoder_pool[k].data_in;
+        delete[] encoder_pool[k].payload_data;
+        delete[] encoder_pool[k].payloads;
+    }
+    if (input != NULL)
+        unmap_file (input);
+    printf ("[client] generation total send: %u\n", retired_generation_num);
     printf ("[client] packet total send: %u\n", tx_packet_count);
     printf ("[client] frame total send: %u\n", tx_frame_count);
+    if (tx_packet_count > 0)
+        printf ("[client] average packet produce time: %.1f us\n", (float)total_time_used / tx_packet_count);
+    if (feedback_enable == true)
+        printf ("[client] estimated loss rate: %.2f\n", loss_estimator.loss);
+    if (coded_count > 0)
+        printf ("[client] average coding density: %.2f\n", density_total / coded_count);
     return 0;
 }
@@ -9,10 +9,17 @@
 #include <time.h>
 #include <stdlib.h>
 #include <signal.h>
+#include <pthread.h>
 
 #include "serial.h"
 #include "lowpan.h"
 #include "reassemble.h"
+#include "coding_vector.h"
+#include "nc_header.h"
+#include "nc_field.h"
+#include "rank_tracker.h"
+#include "recoder_cache.h"
+#include "packet_queue.h"
 #include "utils.h"
 #include "config.h"
 
@@ -30,13 +37,17 @@ static struct option long_options[] =
     {"recode",      no_argument,       0, 'r'},
     {"logFile",     required_argument, 0, 'l'},
     {"density",     no_argument,       0, 'd'},
+    {"field",       required_argument, 0, 'F'},
+    {"memory",      required_argument, 0, 'm'},
+    {"buffer",      required_argument, 0, 'b'},
+    {"duplex",      no_argument,       0, 'x'},
     {"help",        no_argument,       0, 'h'},
     {0, 0, 0, 0}
 };
 
 void usage(void)
 {
-    printf ("Usage: [-p --port <serial port number>] [-s --symbolSize <symbol size>] [-g --genSize <generation size>] [-r --recode] [-l --logFile <log file name>] [-d --density] [-h --help]\n");
+    printf ("Usage: [-p --port <serial port number>] [-s --symbolSize <symbol size>] [-g --genSize <generation size>] [-r --recode] [-l --logFile <log file name>] [-d --density] [-F --field <finite field>] [-m --memory <KiB>] [-b --buffer <symbols>] [-x --duplex] [-h --help]\n");
     printf ("Options:\n");
     printf ("\t-p --port\tserial port number to open\tDefault: /dev/ttyACM0\n");
     printf ("\t-s --symbolSize\tsymbol size\t\t\tDefault: 4\n");
@@ -44,18 +55,74 @@ void usage(void)
     printf ("\t-r --recode\tenable recoding\n");
     printf ("\t-l --logFile\tlog file name\t\t\tDefault: log.dump\n");
     printf ("\t-d --density\tenable sparse coding\n");
+    printf ("\t-F --field\tbinary, binary4, binary8, binary16 or prime2325, must match the client\tDefault: binary8\n");
+    printf ("\t-m --memory\tmemory budget of the recoders of concurrent generations in KiB\tDefault: %u\n", RECODER_CACHE_BUDGET);
+    printf ("\t-b --buffer\tcoded symbols a recoder stores, fewer than the generation size bounds relay memory\tDefault: generation size\n");
+    printf ("\t-x --duplex\treceive on a thread of its own while this one recodes and transmits\n");
     printf ("\t-h --help\tthis help documetation\n");
 }
 
+typedef struct
+{
+    int fd;
+    packet_queue_t* queue;
+    uint16_t* rx_packet_count;
+    uint32_t rx_timeout;    // ms without a packet before reception stops
+} rx_stage_t;
+
+/**
+ * @brief get wall clock time in us
+ */
+uint64_t get_time_us (void)
+{
+    struct timeval now;
+    gettimeofday (&now, NULL);
+    return 1000000 * (uint64_t)now.tv_sec + now.tv_usec;
+}
+
+/**
+ * @brief receive stage of the full duplex relay, reassembles packets and
+ *        queues them for the transmit stage until the link goes quiet
+ */
+void* receive_packets (void* arg)
+{
+    rx_stage_t* stage = (rx_stage_t*)arg;
+    uint8_t rx_buf[MAX_PACKET_SIZE];
+    uint64_t last_rx_time = get_time_us ();
+    int rx_num;
+
+    while (get_time_us () - last_rx_time <= (uint64_t)stage->rx_timeout * 1000)
+    {
+        rx_num = read_serial_port (stage->fd, rx_buf, stage->rx_packet_count, false);
+        if (rx_num == -1)
+        {
+            fprintf (stderr, "error %d read fail: %s\n", errno,  strerror (errno));
+            break;
+        }
+        if (rx_num == 0)
+            continue;
+        last_rx_time = get_time_us ();
+        if (packet_queue_push (stage->queue, rx_buf, rx_num) == false)
+            printf ("transmit stage behind, drop a packet\n");
+    }
+    close_packet_queue (stage->queue);
+    return NULL;
+}
+
 void print_nc_config (kodo_rlnc::pure_recoder* recoder,
-                      bool recode_enable)
+                      recoder_cache_t* cache,
+                      bool recode_enable,
+                      uint8_t field_id)
 {
     // print configuration
     printf ("---------NC configuration---------\n");
+    printf ("finite field:\t\t\t%s\n", get_field_name (field_id));
     printf ("recoder symbol size:\t\t%u\n", recoder->symbol_size());
     printf ("recoder coeff vector size:\t%u\n", recoder->coefficient_vector_size());
+    printf ("recoder buffer depth:\t\t%u\n", recoder->recoder_symbols());
     printf ("recoder payload size:\t\t%u\n", recoder->max_payload_size());
     printf ("recoding enable:\t\t%s\n", recode_enable ? "true" : "false");
+    printf ("cached recoders:\t\t%u\n", cache->capacity);
     printf ("---------NC configuration---------\n");
 }
 
@@ -63,6 +130,11 @@ int write_measurement_log (char* log_file_name,
                            kodo_rlnc::pure_recoder* recoder,
                            bool recode_enable,
                            uint16_t rx_packet_count,
+                           uint16_t fwd_packet_count,
+                           uint16_t dependent_packet_count,
+                           recoder_cache_t* cache,
+                           bool duplex_enable,
+                           uint32_t queue_drop_count,
                            bool sparse_enable)
 {
     FILE* fp;
@@ -73,15 +145,29 @@ int write_measurement_log (char* log_file_name,
         return -1;
     }
     if (sparse_enable == false)
-        fprintf(fp, "{\"type\": \"block_full\", \"gen_size\": %u, \"recode\": %d, \"fwd_num\": %u },\n",
+        fprintf(fp, "{\"type\": \"block_full\", \"gen_size\": %u, \"buffer\": %u, \"recode\": %d, \"duplex\": %d, \"rx_num\": %u, \"fwd_num\": %u, \"dependent_num\": %u, \"queue_drop_num\": %u, \"cache_size\": %u, \"evict_num\": %u },\n",
             recoder->symbols(),
+            recoder->recoder_symbols(),
             recode_enable ? 1 : 0,
-            rx_packet_count);
+            duplex_enable ? 1 : 0,
+            rx_packet_count,
+            fwd_packet_count,
+            dependent_packet_count,
+            queue_drop_count,
+            cache->capacity,
+            cache->eviction_count);
     else
-        fprintf(fp, "{\"type\": \"block_sparse\", \"gen_size\": %u, \"recode\": %d, \"fwd_num\": %u },\n",
+        fprintf(fp, "{\"type\": \"block_sparse\", \"gen_size\": %u, \"buffer\": %u, \"recode\": %d, \"duplex\": %d, \"rx_num\": %u, \"fwd_num\": %u, \"dependent_num\": %u, \"queue_drop_num\": %u, \"cache_size\": %u, \"evict_num\": %u },\n",
             recoder->symbols(),
+            recoder->recoder_symbols(),
             recode_enable ? 1 : 0,
-            rx_packet_count);
+            duplex_enable ? 1 : 0,
+            rx_packet_count,
+            fwd_packet_count,
+            dependent_packet_count,
+            queue_drop_count,
+            cache->capacity,
+            cache->eviction_count);
     fclose(fp);
     return 0;
 }
@@ -94,12 +180,16 @@ int main(int argc, char *argv[])
     uint32_t generation_size = 10;
     bool recode_enable = false;
     bool sparse_enable = false;
+    uint8_t field_id = NC_FIELD_DEFAULT;
+    uint32_t memory_budget = RECODER_CACHE_BUDGET;
+    uint32_t buffer_depth = 0;
+    bool duplex_enable = false;
 
     // cmd arguments parsing
     int opt;
     int option_index = 0;
 
-    while ((opt = getopt_long (argc, argv, "p:s:g:rl:dh", long_options, &option_index)) != -1)
+    while ((opt = getopt_long (argc, argv, "p:s:g:rl:dF:m:b:xh", long_options, &option_index)) != -1)
     {
         switch (opt)
         {
@@ -121,6 +211,22 @@ int main(int argc, char *argv[])
             case 'd':
                 sparse_enable = true;
                 break;
+            case 'F':
+                if (parse_field_name (optarg, &field_id) == false)
+                {
+                    fprintf (stderr, "unknown finite field %s\n", optarg);
+                    return -1;
+                }
+                break;
+            case 'm':
+                memory_budget = atoi (optarg);
+                break;
+            case 'b':
+                buffer_depth = atoi (optarg);
+                break;
+            case 'x':
+                duplex_enable = true;
+                break;
             case 'h':
                 usage ();
                 return 0;
@@ -145,59 +251,109 @@ int main(int argc, char *argv[])
     int ret;
     int rx_num = 0;
     uint16_t rx_packet_count = 0;
+    uint16_t fwd_packet_count = 0;
+    uint16_t dependent_packet_count = 0;
     uint8_t extract_buf[MAX_PACKET_SIZE];
     memset (extract_buf, 0, sizeof extract_buf);
 
-    uint8_t systematic_packet_coeff[4][4] = {
-                                            {1, 0, 0, 0},
-                                            {0, 1, 0, 0},
-                                            {0, 0, 1, 0},
-                                            {0, 0, 0, 1}
-                                            };
-
     // time related variable definition
     clock_t rx_timeout_start = 0;
     uint32_t rx_timeout = 1100; // ms, hard coded
 
     // recoder initialization
-    // set finite field size
-    fifi::finite_field field = fifi::finite_field::binary8;
     // set the number of symbols/combinations that should be stored in the
     // pure recoder. These coded symbols are combinations of previously
     // received symbols. When a new symbol is received, the pure recoder will
     // combine it with its existing symbols using random coefficients.
+    // A buffer shallower than the generation saves relay memory, once it
+    // is full every arrival is mixed into the stored combinations.
     uint32_t recoder_symbols = generation_size;
-    // create an recoder
-    kodo_rlnc::pure_recoder recoder (field, generation_size, symbol_size, recoder_symbols);
-    
+    if (buffer_depth > 0 && buffer_depth < generation_size)
+        recoder_symbols = buffer_depth;
+    // one recoder per generation of every flow, recycled least recently used first
+    recoder_cache_t cache;
+    init_recoder_cache (&cache, field_id, generation_size, symbol_size, recoder_symbols, memory_budget * 1024);
+    // the first recoder sizes the buffers, every recoder of the cache shares its configuration
+    kodo_rlnc::pure_recoder* recoder = cache.entries[0].recoder;
+    recoder_entry_t* entry = NULL;
+    bool fresh = false;
+
     // set buffers
-    uint8_t recoder_symbol[recoder.symbol_size()];
-    uint8_t recoder_symbol_coefficients[recoder.coefficient_vector_size()];
+    uint8_t recoder_symbol[recoder->symbol_size()];
+    uint8_t recoder_symbol_coefficients[recoder->coefficient_vector_size()];
     // buffer for recoding coefficients
-    uint8_t recoder_coefficients[recoder.recoder_coefficient_vector_size()];
+    uint8_t recoder_coefficients[recoder->recoder_coefficient_vector_size()];
     memset (recoder_symbol, 0, sizeof recoder_symbol);
     memset (recoder_symbol_coefficients, 0, sizeof recoder_symbol_coefficients);
     memset (recoder_coefficients, 0, sizeof recoder_coefficients);
+    // unit coding vectors of every systematic symbol of a generation, packed for the field,
+    // built once so a systematic packet is consumed without building its vector
+    uint8_t systematic_packet_coeff[recoder->symbols()][recoder->coefficient_vector_size()];
+    memset (systematic_packet_coeff, 0, sizeof systematic_packet_coeff);
+    for (uint32_t i = 0; i < recoder->symbols(); i++)
+        set_field_value (systematic_packet_coeff[i], field_id, i, 1);
 
-    uint8_t packet[recoder.symbol_size() +
-                   recoder.coefficient_vector_size() +
+    uint8_t packet[recoder->symbol_size() +
+                   get_nc_max_header_size (recoder->coefficient_vector_size()) +
                    IPHC_TOTAL_SIZE +
                    UDPHC_TOTAL_SIZE];
     memset (packet, 0, sizeof packet);
     virtual_packet_t tx_packet[MAX_FRAG_NUM];
     memset (tx_packet, 0, sizeof (virtual_packet_t) * MAX_FRAG_NUM);
     uint32_t tx_packet_length = 0;
+    uint8_t* nc_payload = extract_buf + IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE;
+    nc_header_t header;
+    memset (&header, 0, sizeof header);
+    uint8_t coefficients[recoder->coefficient_vector_size()];
+    // only packets that raise the rank held are recoded and forwarded,
+    // second hop airtime is not spent on what the relay already has
+    rank_tracker_t* tracker = &cache.entries[0].tracker;
+    bool innovative = false;
 
-    print_nc_config (&recoder, recode_enable);
+    print_nc_config (recoder, &cache, recode_enable, field_id);
+
+    // full duplex, reception goes on while this thread recodes and paces the frames it sends,
+    // the recoders are only touched by this thread
+    static packet_queue_t queue;
+    rx_stage_t rx_stage;
+    pthread_t rx_thread;
+    uint32_t queue_poll_interval = 200; // us, hard coded
+    if (duplex_enable == true)
+    {
+        init_packet_queue (&queue);
+        rx_stage.fd = fd;
+        rx_stage.queue = &queue;
+        rx_stage.rx_packet_count = &rx_packet_count;
+        rx_stage.rx_timeout = rx_timeout;
+        if (pthread_create (&rx_thread, NULL, receive_packets, &rx_stage) != 0)
+        {
+            fprintf (stderr, "error creating the receive thread\n");
+            return -1;
+        }
+    }
 
     rx_timeout_start = clock();
     // relay operations
     while (true)
     {
-        if ((clock() - rx_timeout_start) * 1000 / CLOCKS_PER_SEC > rx_timeout)
-            break;
-        // receive a packet
-        rx_num = read_serial_port (fd, extract_buf, &rx_packet_count, false);
+        if (duplex_enable == true)
+        {
+            rx_num = packet_queue_pop (&queue, extract_buf);
+            if (rx_num == 0 && is_packet_queue_drained (&queue) == true)
+                break;
+            if (rx_num == 0)
+            {
+                usleep (queue_poll_interval);
+                continue;
+            }
+        }
+        else
+        {
+            if ((clock() - rx_timeout_start) * 1000 / CLOCKS_PER_SEC > rx_timeout)
+                break;
+            // receive a packet
+            rx_num = read_serial_port (fd, extract_buf, &rx_packet_count, false);
+        }
         if (rx_num == 0)
             continue;
         else if (rx_num == -1)
@@ -209,49 +365,97 @@ int main(int argc, char *argv[])
         if (recode_enable == true)
         {
             printf ("recode a symbol\n");
-            if ((unsigned)rx_num == IPHC_TOTAL_SIZE +
-                                     UDPHC_TOTAL_SIZE +
-                                     sizeof (uint8_t) +
-                                     recoder.symbol_size())
+            if (rx_num <= IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE ||
+                parse_nc_packet (nc_payload,
+                                 rx_num - IPHC_TOTAL_SIZE - UDPHC_TOTAL_SIZE,
+                                 recoder->coefficient_vector_size(),
+                                 recoder->symbol_size(),
+                                 &header) == false ||
+                header.field != field_id)
+            {
+                memset (extract_buf, 0, sizeof extract_buf);
+                continue;
+            }
+            if (header.type == NC_PAYLOAD && (unsigned)rx_num > sizeof packet)
             {
-                // receive a systematic packet
-                // read symbol and coding coefficients into the recoder
-                recoder.consume_symbol (extract_buf + sizeof (uint8_t) +
-                                        IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE,
-                                        systematic_packet_coeff[*(extract_buf + IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE)]);
+                memset (extract_buf, 0, sizeof extract_buf);
+                continue;
             }
-            else if ((unsigned)rx_num == IPHC_TOTAL_SIZE +
-                                     UDPHC_TOTAL_SIZE +
-                                     recoder.coefficient_vector_size() +
-                                     recoder.symbol_size())
+            else if (header.type == NC_PAYLOAD)
             {
-                // receive a coded packet
-                // read symbol and coding coefficients into the recoder
-                recoder.consume_symbol (extract_buf + recoder.coefficient_vector_size() +
-                                        IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE,
-                                        extract_buf + IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE);
+                // kodo payloads can not be recoded with the symbol API, forward them as they are
+                memcpy (packet, extract_buf, rx_num);
+                tx_packet_length = rx_num;
             }
+            else
+            {
+                // the generations of every flow keep their own recoder
+                entry = get_cached_recoder (&cache,
+                                            get_udp_flow (extract_buf + IPHC_TOTAL_SIZE),
+                                            header.generation_id,
+                                            &fresh);
+                recoder = entry->recoder;
+                tracker = &entry->tracker;
+                if (fresh == true)
+                    printf ("cache a recoder for flow %u generation %u\n", entry->flow, entry->generation_id);
+                innovative = false;
+                switch (header.type)
+                {
+                    case NC_SYSTEMATIC:
+                        // the tracker rejects an index outside the generation
+                        innovative = track_systematic_symbol (tracker, header.index);
+                        if (innovative == true)
+                            // read symbol and coding coefficients into the recoder
+                            recoder->consume_symbol (header.symbol,
+                                                    systematic_packet_coeff[header.index]);
+                        break;
+                    case NC_CODED:
+                        innovative = track_coded_symbol (tracker, header.coefficients);
+                        if (innovative == true)
+                            recoder->consume_symbol (header.symbol, header.coefficients);
+                        break;
+                    case NC_SEEDED:
+                        // recoded packets fall back to the full coding vector
+                        generate_seeded_coefficients (coefficients,
+                                                      recoder->symbols(),
+                                                      header.seed,
+                                                      header.density,
+                                                      field_id);
+                        innovative = track_coded_symbol (tracker, coefficients);
+                        if (innovative == true)
+                            recoder->consume_symbol (header.symbol, coefficients);
+                        break;
+                }
+                // a dependent packet is dropped, unless it closes a rateless round
+                if (innovative == false)
+                    dependent_packet_count++;
+                if (innovative == false && (header.flags & NC_FLAG_ROUND_END) == 0)
+                {
+                    printf ("drop a non-innovative symbol, rank %u\n", get_tracked_rank (tracker));
+                    memset (extract_buf, 0, sizeof extract_buf);
+                    continue;
+                }
 
-            // generate recoding coefficients
-            recoder.recoder_generate (recoder_coefficients);
-            // write an encoded symbol based on the recoding coefficients
-            recoder.recoder_produce_symbol (recoder_symbol,
-                                            recoder_symbol_coefficients,
-                                            recoder_coefficients);
-            // construct packet
-            set_ip_header (packet);
-            set_udp_header (packet + IPHC_TOTAL_SIZE);
-            memcpy (packet + IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE,
-                    recoder_symbol_coefficients,
-                    sizeof recoder_symbol_coefficients);
-            memcpy (packet + sizeof recoder_symbol_coefficients +
-                    IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE,
-                    recoder_symbol,
-                    sizeof recoder_symbol);
-            tx_packet_length = IPHC_TOTAL_SIZE +
-                               UDPHC_TOTAL_SIZE +
-                               sizeof recoder_symbol_coefficients +
-                               sizeof recoder_symbol;
+                // generate recoding coefficients
+                recoder->recoder_generate (recoder_coefficients);
+                // write an encoded symbol based on the recoding coefficients
+                recoder->recoder_produce_symbol (recoder_symbol,
+                                                recoder_symbol_coefficients,
+                                                recoder_coefficients);
+                // construct packet
+                set_ip_header (packet);
+                set_udp_header (packet + IPHC_TOTAL_SIZE);
+                set_udp_flow (packet + IPHC_TOTAL_SIZE, entry->flow);
+                header.type = NC_CODED;
+                header.flags = NC_FLAG_RECODED | (header.flags & NC_FLAG_ROUND_END);
+                header.length = sizeof recoder_symbol;
+                header.coefficients = recoder_symbol_coefficients;
+                header.coefficient_size = sizeof recoder_symbol_coefficients;
+                header.symbol = recoder_symbol;
+                tx_packet_length = IPHC_TOTAL_SIZE +
+                                   UDPHC_TOTAL_SIZE +
+                                   write_nc_packet (packet + IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE, &header);
+            }
             memset (extract_buf, 0, sizeof extract_buf);
         }
         else
@@ -263,7 +467,8 @@ int main(int argc, char *argv[])
 
         // forward packet
         // fragmentation
-        if (need_fragmentation (rx_num) == true)
+        // a recoded packet carries the full coding vector, it can outgrow its input
+        if (need_fragmentation (tx_packet_length) == true)
         {
             printf ("lowpan fragmentation needed\n");
             do_fragmentation (tx_packet, packet, tx_packet_length);
@@ -284,14 +489,30 @@ int main(int argc, char *argv[])
                 return -1;
             printf ("forward a packet\n");
         }
+        fwd_packet_count++;
     } // end of while
-    printf ("packet total forward: %u\n", rx_packet_count);
+    if (duplex_enable == true)
+        pthread_join (rx_thread, NULL);
+    printf ("packet total receive: %u\n", rx_packet_count);
+    printf ("packet total forward: %u\n", fwd_packet_count);
+    if (duplex_enable == true)
+        printf ("packet total drop at the transmit queue: %u\n", queue.drop_count);
+    if (recode_enable == true)
+        printf ("non-innovative packet total receive: %u\n", dependent_packet_count);
+    if (recode_enable == true)
+        printf ("recoder cache hit: %u, miss: %u, eviction: %u\n", cache.hit_count, cache.miss_count, cache.eviction_count);
     // write log to json file
     ret = write_measurement_log (log_file_name,
-                                 &recoder,
+                                 recoder,
                                  recode_enable,
                                  rx_packet_count,
+                                 fwd_packet_count,
+                                 dependent_packet_count,
+                                 &cache,
+                                 duplex_enable,
+                                 duplex_enable == true ? queue.drop_count : 0,
                                  sparse_enable);
+    free_recoder_cache (&cache);
     if (ret < 0)
         return -1;
     return 0;
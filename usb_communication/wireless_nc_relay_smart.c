@@ -13,6 +13,11 @@
 #include "serial.h"
 #include "lowpan.h"
 #include "reassemble.h"
+#include "coding_vector.h"
+#include "nc_header.h"
+#include "nc_field.h"
+#include "rank_tracker.h"
+#include "recoder_cache.h"
 #include "utils.h"
 #include "config.h"
 
@@ -31,13 +36,18 @@ static struct option long_options[] =
     {"logFile",     required_argument, 0, 'l'},
     {"redundancy",  required_argument, 0, 'r'},
     {"density",     no_argument,       0, 'd'},
+    {"field",       required_argument, 0, 'F'},
+    {"online",      no_argument,       0, 'o'},
+    {"memory",      required_argument, 0, 'm'},
+    {"buffer",      required_argument, 0, 'b'},
+    {"decode",      no_argument,       0, 'D'},
     {"help",        no_argument,       0, 'h'},
     {0, 0, 0, 0}
 };
 
 void usage(void)
 {
-    printf ("Usage: [-p --port <serial port number>] [-s --symbolSize <symbol size>] [-g --genSize <generation size>] [-c --recode] [-l --logFile <log file name>] [-r --redundancy <redundancy in percent>] [-d --density] [-h --help]\n");
+    printf ("Usage: [-p --port <serial port number>] [-s --symbolSize <symbol size>] [-g --genSize <generation size>] [-c --recode] [-l --logFile <log file name>] [-r --redundancy <redundancy in percent>] [-d --density] [-F --field <finite field>] [-o --online] [-m --memory <KiB>] [-b --buffer <symbols>] [-D --decode] [-h --help]\n");
     printf ("Options:\n");
     printf ("\t-p --port\tserial port number to open\tDefault: /dev/ttyACM0\n");
     printf ("\t-s --symbolSize\tsymbol size\t\t\tDefault: 4\n");
@@ -46,20 +56,40 @@ void usage(void)
     printf ("\t-l --logFile\tlog file name\t\t\tDefault: log.dump\n");
     printf ("\t-r --redundancy\tredundancy in percent\t\tDefault: 20\n");
     printf ("\t-d --density\tenable sparse coding\n");
+    printf ("\t-F --field\tbinary, binary4, binary8, binary16 or prime2325, must match the client\tDefault: binary8\n");
+    printf ("\t-o --online\trecode and forward every innovative packet as it arrives instead of buffering the generation\n");
+    printf ("\t-m --memory\tmemory budget of the recoders of concurrent generations with -o, in KiB\tDefault: %u\n", RECODER_CACHE_BUDGET);
+    printf ("\t-b --buffer\tcoded symbols a recoder stores, fewer than the generation size bounds relay memory\tDefault: generation size\n");
+    printf ("\t-D --decode\tdecode the generation, forward source symbols as they are decoded and send own repair symbols, -r sets the redundancy of the next hop\n");
     printf ("\t-h --help\tthis help documetation\n");
 }
 
+/**
+ * @brief get wall clock time in us
+ */
+uint64_t get_time_us (void)
+{
+    struct timeval now;
+    gettimeofday (&now, NULL);
+    return 1000000 * (uint64_t)now.tv_sec + now.tv_usec;
+}
+
 void print_nc_config (kodo_rlnc::pure_recoder* recoder,
+                      recoder_cache_t* cache,
                       float redundancy,
-                      bool recode_enable)
+                      bool recode_enable,
+                      uint8_t field_id)
 {
     // print configuration
     printf ("---------NC configuration---------\n");
+    printf ("finite field:\t\t\t%s\n", get_field_name (field_id));
     printf ("recoder symbol size:\t\t%u\n", recoder->symbol_size());
     printf ("recoder coeff vector size:\t%u\n", recoder->coefficient_vector_size());
+    printf ("recoder buffer depth:\t\t%u\n", recoder->recoder_symbols());
     printf ("recoder payload size:\t\t%u\n", recoder->max_payload_size());
     printf ("redundancy ratio:\t\t%.2f\n", redundancy);
     printf ("recoding enable:\t\t%s\n", recode_enable ? "true" : "false");
+    printf ("cached recoders:\t\t%u\n", cache->capacity);
     printf ("---------NC configuration---------\n");
 }
 
@@ -68,8 +98,14 @@ int write_measurement_log (char* log_file_name,
                            bool recode_enable,
                            uint16_t rx_packet_count,
                            uint16_t fwd_packet_count,
+                           uint16_t dependent_packet_count,
+                           uint32_t rank,
                            float redundancy,
-                           bool sparse_enable)
+                           bool sparse_enable,
+                           bool online_enable,
+                           bool decode_enable,
+                           uint64_t first_fwd_delay,
+                           uint64_t coding_time)
 {
     FILE* fp;
     fp = fopen (log_file_name, "a+");
@@ -79,23 +115,95 @@ int write_measurement_log (char* log_file_name,
         return -1;
     }
     if (sparse_enable == false)
-        fprintf(fp, "{\"type\": \"block_full\", \"gen_size\": %u, \"redundancy\": %.2f, \"recode\": %d, \"rx_num\": %u, \"fwd_num\": %u },\n",
+        fprintf(fp, "{\"type\": \"block_full\", \"gen_size\": %u, \"buffer\": %u, \"redundancy\": %.2f, \"recode\": %d, \"online\": %d, \"decode\": %d, \"rx_num\": %u, \"fwd_num\": %u, \"dependent_num\": %u, \"rank\": %u, \"first_fwd_ms\": %.2f, \"coding_us\": %llu },\n",
             recoder->symbols(),
+            recoder->recoder_symbols(),
             redundancy,
             recode_enable ? 1 : 0,
+            online_enable ? 1 : 0,
+            decode_enable ? 1 : 0,
             rx_packet_count,
-            fwd_packet_count);
+            fwd_packet_count,
+            dependent_packet_count,
+            rank,
+            (float)first_fwd_delay / 1000,
+            (unsigned long long)coding_time);
     else
-        fprintf(fp, "{\"type\": \"block_sparse\", \"gen_size\": %u, \"redundancy\": %.2f, \"recode\": %d, \"rx_num\": %u, \"fwd_num\": %u },\n",
+        fprintf(fp, "{\"type\": \"block_sparse\", \"gen_size\": %u, \"buffer\": %u, \"redundancy\": %.2f, \"recode\": %d, \"online\": %d, \"decode\": %d, \"rx_num\": %u, \"fwd_num\": %u, \"dependent_num\": %u, \"rank\": %u, \"first_fwd_ms\": %.2f, \"coding_us\": %llu },\n",
             recoder->symbols(),
+            recoder->recoder_symbols(),
             redundancy,
             recode_enable ? 1 : 0,
+            online_enable ? 1 : 0,
+            decode_enable ? 1 : 0,
             rx_packet_count,
-            fwd_packet_count);
+            fwd_packet_count,
+            dependent_packet_count,
+            rank,
+            (float)first_fwd_delay / 1000,
+            (unsigned long long)coding_time);
     fclose(fp);
     return 0;
 }
 
+/**
+ * @brief recode a packet of the symbols held, return packet length
+ */
+uint32_t produce_recoded_packet (kodo_rlnc::pure_recoder* recoder,
+                                 nc_header_t* header,
+                                 uint8_t* recoder_symbol,
+                                 uint8_t* recoder_symbol_coefficients,
+                                 uint8_t* recoder_coefficients,
+                                 uint8_t flow,
+                                 uint8_t* packet)
+{
+    // generate recoding coefficients
+    recoder->recoder_generate (recoder_coefficients);
+    // write an encoded symbol based on the recoding coefficients
+    recoder->recoder_produce_symbol (recoder_symbol,
+                                     recoder_symbol_coefficients,
+                                     recoder_coefficients);
+    // construct packet
+    set_ip_header (packet);
+    set_udp_header (packet + IPHC_TOTAL_SIZE);
+    set_udp_flow (packet + IPHC_TOTAL_SIZE, flow);
+    header->type = NC_CODED;
+    header->length = recoder->symbol_size();
+    header->coefficients = recoder_symbol_coefficients;
+    header->coefficient_size = recoder->coefficient_vector_size();
+    header->symbol = recoder_symbol;
+    return IPHC_TOTAL_SIZE +
+           UDPHC_TOTAL_SIZE +
+           write_nc_packet (packet + IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE, header);
+}
+
+/**
+ * @brief frame a packet and write it to the serial port, a packet larger than a
+ *        frame is fragmented and the fragments are spaced by the inter frame interval,
+ *        return -1 on write failure
+ */
+int write_relay_packet (int fd,
+                        virtual_packet_t tx_packet[],
+                        uint8_t* packet,
+                        uint32_t length,
+                        uint32_t inter_frame_interval)
+{
+    if (need_fragmentation (length) == false)
+    {
+        generate_normal_packet (&tx_packet[0], packet, length);
+        return write_serial_port (fd, tx_packet[0].packet, tx_packet[0].length) < 0 ? -1 : 0;
+    }
+    do_fragmentation (tx_packet, packet, length);
+    for (uint8_t j = 0; j < get_fragment_num(); j++)
+    {
+        if (j > 0)
+            usleep (inter_frame_interval);
+        if (write_serial_port (fd, tx_packet[j].packet, tx_packet[j].length) < 0)
+            return -1;
+    }
+    return 0;
+}
+
 int main(int argc, char *argv[])
 {
     char* serial_port = (char*)USB_DEVICE;
@@ -105,12 +213,17 @@ int main(int argc, char *argv[])
     float redundancy = 0.2;
     bool recode_enable = false;
     bool sparse_enable = false;
+    uint8_t field_id = NC_FIELD_DEFAULT;
+    bool online_enable = false;
+    uint32_t memory_budget = RECODER_CACHE_BUDGET;
+    uint32_t buffer_depth = 0;
+    bool decode_enable = false;
 
     // cmd arguments parsing
     int opt;
     int option_index = 0;
 
-    while ((opt = getopt_long (argc, argv, "p:s:g:cl:r:dh", long_options, &option_index)) != -1)
+    while ((opt = getopt_long (argc, argv, "p:s:g:cl:r:dF:om:b:Dh", long_options, &option_index)) != -1)
     {
         switch (opt)
         {
@@ -135,6 +248,25 @@ int main(int argc, char *argv[])
             case 'd':
                 sparse_enable = true;
                 break;
+            case 'F':
+                if (parse_field_name (optarg, &field_id) == false)
+                {
+                    fprintf (stderr, "unknown finite field %s\n", optarg);
+                    return -1;
+                }
+                break;
+            case 'o':
+                online_enable = true;
+                break;
+            case 'm':
+                memory_budget = atoi (optarg);
+                break;
+            case 'b':
+                buffer_depth = atoi (optarg);
+                break;
+            case 'D':
+                decode_enable = true;
+                break;
             case 'h':
                 usage ();
                 return 0;
@@ -160,56 +292,424 @@ int main(int argc, char *argv[])
     int rx_num = 0;
     uint16_t rx_packet_count = 0;
     uint16_t fwd_packet_count = 0;
+    uint16_t dependent_packet_count = 0;
     uint8_t extract_buf[MAX_PACKET_SIZE];
     memset (extract_buf, 0, sizeof extract_buf);
 
-    uint8_t systematic_packet_coeff[4][4] = {
-                                            {1, 0, 0, 0},
-                                            {0, 1, 0, 0},
-                                            {0, 0, 1, 0},
-                                            {0, 0, 0, 1}
-                                            };
-
     // time related variable definition
     clock_t rx_timeout_start = 0;
     uint32_t rx_timeout = 700; // ms, hard coded
+    uint64_t now_time = 0; // us
+    uint64_t first_rx_time = 0; // us
+    uint64_t first_fwd_time = 0; // us
+    uint64_t coding_start = 0; // us
+    uint64_t coding_time = 0; // us, spent in the coders of the online and decode modes
 
     // recoder initialization
-    // set finite field size
-    fifi::finite_field field = fifi::finite_field::binary8;
     // set the number of symbols/combinations that should be stored in the
     // pure recoder. These coded symbols are combinations of previously
     // received symbols. When a new symbol is received, the pure recoder will
     // combine it with its existing symbols using random coefficients.
+    // A buffer shallower than the generation saves relay memory, once it
+    // is full every arrival is mixed into the stored combinations.
     uint32_t recoder_symbols = generation_size;
-    // create an recoder
-    kodo_rlnc::pure_recoder recoder (field, generation_size, symbol_size, recoder_symbols);
+    if (buffer_depth > 0 && buffer_depth < generation_size)
+        recoder_symbols = buffer_depth;
+    // one recoder per generation of every flow when relaying online, the buffered
+    // relay holds a single generation and uses the first one
+    recoder_cache_t cache;
+    init_recoder_cache (&cache,
+                        field_id,
+                        generation_size,
+                        symbol_size,
+                        recoder_symbols,
+                        online_enable == true ? memory_budget * 1024 : 0);
+    // the first recoder sizes the buffers, every recoder of the cache shares its configuration
+    kodo_rlnc::pure_recoder* recoder = cache.entries[0].recoder;
+    rank_tracker_t* tracker = &cache.entries[0].tracker;
+    recoder_entry_t* entry = NULL;
+    bool fresh = false;
 
     // set buffers
-    uint8_t recoder_symbol[recoder.symbol_size()];
-    uint8_t recoder_symbol_coefficients[recoder.coefficient_vector_size()];
+    uint8_t recoder_symbol[recoder->symbol_size()];
+    uint8_t recoder_symbol_coefficients[recoder->coefficient_vector_size()];
     // buffer for recoding coefficients
-    uint8_t recoder_coefficients[recoder.recoder_coefficient_vector_size()];
+    uint8_t recoder_coefficients[recoder->recoder_coefficient_vector_size()];
     memset (recoder_symbol, 0, sizeof recoder_symbol);
     memset (recoder_symbol_coefficients, 0, sizeof recoder_symbol_coefficients);
     memset (recoder_coefficients, 0, sizeof recoder_coefficients);
+    // unit coding vectors of every systematic symbol of a generation, packed for the field,
+    // built once so a systematic packet is consumed without building its vector
+    uint8_t systematic_packet_coeff[recoder->symbols()][recoder->coefficient_vector_size()];
+    memset (systematic_packet_coeff, 0, sizeof systematic_packet_coeff);
+    for (uint32_t i = 0; i < recoder->symbols(); i++)
+        set_field_value (systematic_packet_coeff[i], field_id, i, 1);
 
-    uint8_t packet[recoder.symbol_size() +
-                   recoder.coefficient_vector_size() +
+    uint8_t packet[recoder->symbol_size() +
+                   get_nc_max_header_size (recoder->coefficient_vector_size()) +
                    IPHC_TOTAL_SIZE +
                    UDPHC_TOTAL_SIZE];
     memset (packet, 0, sizeof packet);
     virtual_packet_t tx_packet[MAX_FRAG_NUM];
     memset (tx_packet, 0, sizeof (virtual_packet_t) * MAX_FRAG_NUM);
-    virtual_packet_t rx_packet[MAX_FRAG_NUM];
-    memset (rx_packet, 0, sizeof (virtual_packet_t) * MAX_FRAG_NUM);
+    // a generation and its redundancy are buffered before recoding
+    uint16_t rx_packet_capacity = 2 * generation_size > MAX_FRAG_NUM ? 2 * generation_size : MAX_FRAG_NUM;
+    // reassembled packets, up to the largest packet of the configuration
+    uint8_t rx_packet[rx_packet_capacity][sizeof packet];
+    uint16_t rx_packet_length[rx_packet_capacity];
+    memset (rx_packet, 0, sizeof rx_packet);
+    memset (rx_packet_length, 0, sizeof rx_packet_length);
     uint32_t tx_packet_length = 0;
+    uint8_t* nc_payload = NULL;
+    uint8_t generation_id = 0;
+    uint8_t flow_id = 0;
+    bool round_end = false;
+    nc_header_t header;
+    memset (&header, 0, sizeof header);
+    uint8_t coefficients[recoder->coefficient_vector_size()];
+
+    print_nc_config (recoder, &cache, redundancy, recode_enable, field_id);
+
+    // online relaying, every innovative arrival is recoded and forwarded at once,
+    // the repair budget of the buffered relay is spent on rank milestones and idle periods
+    bool innovative = false;
+    uint32_t milestone_step = generation_size / 4 > 0 ? generation_size / 4 : 1;
+    uint32_t repair_interval = 100; // ms without arrivals before a repair packet, hard coded
+    uint64_t last_rx_time = get_time_us ();
+    uint64_t last_tx_time = 0;
+    while (online_enable == true && decode_enable == false)
+    {
+        now_time = get_time_us ();
+        if (now_time - last_rx_time > (uint64_t)rx_timeout * 1000)
+            break;
+        rx_num = read_serial_port (fd, extract_buf, &rx_packet_count, false);
+        if (rx_num == -1)
+        {
+            fprintf (stderr, "error %d read fail: %s\n", errno,  strerror (errno));
+            break;
+        }
+        if (rx_num > 0)
+        {
+            last_rx_time = now_time;
+            if (first_rx_time == 0)
+                first_rx_time = now_time;
+            nc_payload = extract_buf + IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE;
+            innovative = false;
+            if (recode_enable == true &&
+                (rx_num <= IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE ||
+                 parse_nc_packet (nc_payload,
+                                  rx_num - IPHC_TOTAL_SIZE - UDPHC_TOTAL_SIZE,
+                                  recoder->coefficient_vector_size(),
+                                  recoder->symbol_size(),
+                                  &header) == false ||
+                 header.field != field_id))
+            {
+                memset (extract_buf, 0, sizeof extract_buf);
+                continue;
+            }
+            if (recode_enable == false || header.type == NC_PAYLOAD)
+            {
+                // nothing to recode, forward as it is
+                ret = write_relay_packet (fd, tx_packet, extract_buf, rx_num, inter_frame_interval);
+                if (ret < 0)
+                    return -1;
+                fwd_packet_count++;
+                last_tx_time = now_time;
+                if (first_fwd_time == 0)
+                    first_fwd_time = now_time;
+                printf ("[relay] forward a packet\n");
+                memset (extract_buf, 0, sizeof extract_buf);
+                continue;
+            }
+            // the generations of every flow keep their own recoder and repair budget
+            entry = get_cached_recoder (&cache,
+                                        get_udp_flow (extract_buf + IPHC_TOTAL_SIZE),
+                                        header.generation_id,
+                                        &fresh);
+            recoder = entry->recoder;
+            tracker = &entry->tracker;
+            if (fresh == true)
+                entry->repair_budget = generation_size * (redundancy / 2);
+            entry->last_rx_time = now_time;
+            coding_start = get_time_us ();
+            switch (header.type)
+            {
+                case NC_SYSTEMATIC:
+                    // the tracker rejects an index outside the generation
+                    innovative = track_systematic_symbol (tracker, header.index);
+                    if (innovative == true)
+                        recoder->consume_symbol (header.symbol,
+                                                systematic_packet_coeff[header.index]);
+                    break;
+                case NC_CODED:
+                    innovative = track_coded_symbol (tracker, header.coefficients);
+                    if (innovative == true)
+                        recoder->consume_symbol (header.symbol, header.coefficients);
+                    break;
+                case NC_SEEDED:
+                    // recoded packets fall back to the full coding vector
+                    generate_seeded_coefficients (coefficients,
+                                                  recoder->symbols(),
+                                                  header.seed,
+                                                  header.density,
+                                                  field_id);
+                    innovative = track_coded_symbol (tracker, coefficients);
+                    if (innovative == true)
+                        recoder->consume_symbol (header.symbol, coefficients);
+                    break;
+            }
+            coding_time += get_time_us () - coding_start;
+            if (innovative == false)
+                dependent_packet_count++;
+            // a round end is passed on even if its packet brought nothing new
+            if (innovative == true || (header.flags & NC_FLAG_ROUND_END) != 0)
+            {
+                header.flags = NC_FLAG_RECODED | (header.flags & NC_FLAG_ROUND_END);
+                coding_start = get_time_us ();
+                tx_packet_length = produce_recoded_packet (recoder,
+                                                           &header,
+                                                           recoder_symbol,
+                                                           recoder_symbol_coefficients,
+                                                           recoder_coefficients,
+                                                           entry->flow,
+                                                           packet);
+                coding_time += get_time_us () - coding_start;
+                ret = write_relay_packet (fd, tx_packet, packet, tx_packet_length, inter_frame_interval);
+                if (ret < 0)
+                    return -1;
+                fwd_packet_count++;
+                last_tx_time = get_time_us ();
+                if (first_fwd_time == 0)
+                    first_fwd_time = last_tx_time;
+                printf ("[relay] forward a recoded packet, rank %u\n", get_tracked_rank (tracker));
+            }
+            // a repair packet at every rank milestone while the budget lasts
+            if (innovative == true &&
+                entry->repair_budget > entry->repair_due &&
+                (get_tracked_rank (tracker) % milestone_step == 0 ||
+                 get_tracked_rank (tracker) == recoder->symbols()))
+                entry->repair_due++;
+            memset (extract_buf, 0, sizeof extract_buf);
+        }
+        if (now_time - last_tx_time < inter_frame_interval)
+            continue;
+
+        // a quiet generation spends the rest of its budget, one packet per interval,
+        // and one due repair packet of any generation goes out per frame interval
+        entry = NULL;
+        for (uint32_t i = 0; i < cache.size && entry == NULL; i++)
+        {
+            if (cache.entries[i].used == false || cache.entries[i].repair_budget == 0)
+                continue;
+            if (cache.entries[i].repair_due == 0 &&
+                now_time - cache.entries[i].last_rx_time >= (uint64_t)repair_interval * 1000 &&
+                now_time - last_tx_time >= (uint64_t)repair_interval * 1000)
+                cache.entries[i].repair_due++;
+            if (cache.entries[i].repair_due > 0)
+                entry = &cache.entries[i];
+        }
+        // due repair packets are paced, reception goes on in between
+        if (entry != NULL)
+        {
+            header.generation_id = entry->generation_id;
+            header.field = field_id;
+            header.flags = NC_FLAG_RECODED;
+            coding_start = get_time_us ();
+            tx_packet_length = produce_recoded_packet (entry->recoder,
+                                                       &header,
+                                                       recoder_symbol,
+                                                       recoder_symbol_coefficients,
+                                                       recoder_coefficients,
+                                                       entry->flow,
+                                                       packet);
+            coding_time += get_time_us () - coding_start;
+            ret = write_relay_packet (fd, tx_packet, packet, tx_packet_length, inter_frame_interval);
+            if (ret < 0)
+                return -1;
+            fwd_packet_count++;
+            entry->repair_due--;
+            entry->repair_budget--;
+            last_tx_time = now_time;
+            printf ("[relay] forward a repair packet of flow %u generation %u, %u left\n",
+                    entry->flow, entry->generation_id, entry->repair_budget);
+        }
+    }
 
-    print_nc_config (&recoder, redundancy, recode_enable);
+    // decode and forward, the relay decodes the generation and forwards every source
+    // symbol once it is decoded, then its own encoder codes fresh repair symbols, so
+    // each hop carries the redundancy its own loss needs. A single generation is held
+    kodo_rlnc::decoder* decoder = NULL;
+    kodo_rlnc::encoder* encoder = NULL;
+    if (decode_enable == true)
+    {
+        decoder = new kodo_rlnc::decoder ((fifi::finite_field)field_id, generation_size, symbol_size);
+        encoder = new kodo_rlnc::encoder ((fifi::finite_field)field_id, generation_size, symbol_size);
+    }
+    uint8_t decoded_data[generation_size * symbol_size];
+    bool symbol_forwarded[generation_size];
+    bool generation_held = false;
+    bool encoder_loaded = false;
+    uint16_t repair_left = 0;
+    uint32_t decoded_rank = 0;
+    int32_t forward_index = -1;
+    memset (decoded_data, 0, sizeof decoded_data);
+    memset (symbol_forwarded, 0, sizeof symbol_forwarded);
+    last_rx_time = get_time_us ();
+    last_tx_time = 0;
+    while (decode_enable == true)
+    {
+        now_time = get_time_us ();
+        // idle, the symbols and repair packets still due are sent first
+        if (now_time - last_rx_time > (uint64_t)rx_timeout * 1000 &&
+            (generation_held == false || forward_index < 0) &&
+            (generation_held == false || decoder->is_complete() == false || repair_left == 0))
+            break;
+        rx_num = read_serial_port (fd, extract_buf, &rx_packet_count, false);
+        if (rx_num == -1)
+        {
+            fprintf (stderr, "error %d read fail: %s\n", errno,  strerror (errno));
+            break;
+        }
+        if (rx_num > 0)
+        {
+            last_rx_time = now_time;
+            if (first_rx_time == 0)
+                first_rx_time = now_time;
+            nc_payload = extract_buf + IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE;
+            if (rx_num <= IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE ||
+                parse_nc_packet (nc_payload,
+                                 rx_num - IPHC_TOTAL_SIZE - UDPHC_TOTAL_SIZE,
+                                 recoder->coefficient_vector_size(),
+                                 recoder->symbol_size(),
+                                 &header) == false ||
+                header.field != field_id)
+            {
+                memset (extract_buf, 0, sizeof extract_buf);
+                continue;
+            }
+            if (header.type == NC_PAYLOAD)
+            {
+                // kodo payloads can not be decoded with the symbol API, forward them as they are
+                ret = write_relay_packet (fd, tx_packet, extract_buf, rx_num, inter_frame_interval);
+                if (ret < 0)
+                    return -1;
+                fwd_packet_count++;
+                last_tx_time = now_time;
+                if (first_fwd_time == 0)
+                    first_fwd_time = now_time;
+                printf ("[relay] forward a packet\n");
+                memset (extract_buf, 0, sizeof extract_buf);
+                continue;
+            }
+            // a new generation replaces the one held, whatever is still due of it
+            if (generation_held == false || header.generation_id != generation_id)
+            {
+                generation_id = header.generation_id;
+                flow_id = get_udp_flow (extract_buf + IPHC_TOTAL_SIZE);
+                decoder->reset ();
+                decoder->set_symbols_storage (decoded_data);
+                decoder->set_status_updater_on ();
+                memset (symbol_forwarded, 0, sizeof symbol_forwarded);
+                repair_left = generation_size * redundancy;
+                encoder_loaded = false;
+                generation_held = true;
+            }
+            decoded_rank = decoder->rank ();
+            coding_start = get_time_us ();
+            switch (header.type)
+            {
+                case NC_SYSTEMATIC:
+                    if (header.index < decoder->symbols() &&
+                        decoder->is_symbol_decoded (header.index) == false)
+                        decoder->consume_systematic_symbol (header.symbol, header.index);
+                    break;
+                case NC_CODED:
+                    // the decoder works in place on the receive buffer, cleared below
+                    decoder->consume_symbol (header.symbol, header.coefficients);
+                    break;
+                case NC_SEEDED:
+                    generate_seeded_coefficients (coefficients,
+                                                  decoder->symbols(),
+                                                  header.seed,
+                                                  header.density,
+                                                  field_id);
+                    decoder->consume_symbol (header.symbol, coefficients);
+                    break;
+            }
+            coding_time += get_time_us () - coding_start;
+            if (decoder->rank () == decoded_rank)
+                dependent_packet_count++;
+            memset (extract_buf, 0, sizeof extract_buf);
+        }
+        if (generation_held == false)
+            continue;
+        // the next decoded source symbol still to forward, in index order
+        forward_index = -1;
+        for (uint32_t i = 0; i < decoder->symbols() && forward_index < 0; i++)
+        {
+            if (symbol_forwarded[i] == false && decoder->is_symbol_decoded (i) == true)
+                forward_index = i;
+        }
+        if (now_time - last_tx_time < inter_frame_interval)
+            continue;
+
+        // one packet per frame interval, decoded source symbols first, then repair
+        if (forward_index >= 0)
+        {
+            header.type = NC_SYSTEMATIC;
+            header.index = (uint8_t)forward_index;
+            header.symbol = decoded_data + forward_index * symbol_size;
+            symbol_forwarded[forward_index] = true;
+        }
+        else if (decoder->is_complete() == true && repair_left > 0)
+        {
+            coding_start = get_time_us ();
+            if (encoder_loaded == false)
+            {
+                encoder->reset ();
+                encoder->set_seed ((uint32_t)rand ());
+                encoder->set_systematic_off ();
+                encoder->set_symbols_storage (decoded_data);
+                encoder_loaded = true;
+            }
+            encoder->generate (recoder_symbol_coefficients);
+            encoder->produce_symbol (recoder_symbol, recoder_symbol_coefficients);
+            coding_time += get_time_us () - coding_start;
+            header.type = NC_CODED;
+            header.coefficients = recoder_symbol_coefficients;
+            header.coefficient_size = encoder->coefficient_vector_size();
+            header.symbol = recoder_symbol;
+            repair_left--;
+        }
+        else
+            continue;
+        // construct packet
+        set_ip_header (packet);
+        set_udp_header (packet + IPHC_TOTAL_SIZE);
+        set_udp_flow (packet + IPHC_TOTAL_SIZE, flow_id);
+        header.generation_id = generation_id;
+        header.field = field_id;
+        header.flags = NC_FLAG_RECODED;
+        header.length = symbol_size;
+        tx_packet_length = IPHC_TOTAL_SIZE +
+                           UDPHC_TOTAL_SIZE +
+                           write_nc_packet (packet + IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE, &header);
+        ret = write_relay_packet (fd, tx_packet, packet, tx_packet_length, inter_frame_interval);
+        if (ret < 0)
+            return -1;
+        fwd_packet_count++;
+        last_tx_time = now_time;
+        if (first_fwd_time == 0)
+            first_fwd_time = now_time;
+        if (header.type == NC_SYSTEMATIC)
+            printf ("[relay] forward decoded symbol %u, rank %u\n", header.index, decoder->rank ());
+        else
+            printf ("[relay] forward a repair packet, %u left\n", repair_left);
+    }
 
     rx_timeout_start = clock();
     // relay operations
-    while (true)
+    while (online_enable == false && decode_enable == false)
     {
         if ((clock() - rx_timeout_start) * 1000 / CLOCKS_PER_SEC > rx_timeout)
             break;
@@ -222,11 +722,20 @@ int main(int argc, char *argv[])
             fprintf (stderr, "error %d read fail: %s\n", errno,  strerror (errno));
             break;
         }
-        // save packet
-        memcpy (rx_packet[rx_packet_count - 1].packet,
-                extract_buf,
-                rx_num);
-        rx_packet[rx_packet_count - 1].length = rx_num;
+        if (first_rx_time == 0)
+            first_rx_time = get_time_us ();
+        if (rx_packet_count > rx_packet_capacity)
+        {
+            // buffer full, the generation already has plenty of packets
+            memset (extract_buf, 0, sizeof extract_buf);
+            continue;
+        }
+        // save packet, one larger than the configuration allows is left empty
+        if ((uint32_t)rx_num <= sizeof rx_packet[0])
+        {
+            memcpy (rx_packet[rx_packet_count - 1], extract_buf, rx_num);
+            rx_packet_length[rx_packet_count - 1] = rx_num;
+        }
         // clear extract buf
         memset (extract_buf, 0, sizeof extract_buf);
     } // end of while
@@ -236,66 +745,90 @@ int main(int argc, char *argv[])
     // check full rank or not
     // if so, conduct forwarding
     // if redundancy = 0, also conduct forwarding
-    if (rx_packet_count >= generation_size || redundancy == 0)
+    if (online_enable == false && decode_enable == false &&
+        (rx_packet_count >= generation_size || redundancy == 0))
     {
         if (recode_enable == true)
         {
             //printf ("recode a symbol\n");
-            fwd_packet_count = rx_packet_count + generation_size * (redundancy / 2);
-            // feed packets into recoder
-            for (uint8_t i = 0; i < rx_packet_count; i++)
+            // feed the innovative packets into recoder, dependent ones are dropped
+            for (uint16_t i = 0; i < rx_packet_count && i < rx_packet_capacity; i++)
             {
-                if (rx_packet[i].length == IPHC_TOTAL_SIZE +
-                                           UDPHC_TOTAL_SIZE +
-                                           sizeof (uint8_t) +
-                                           recoder.symbol_size())
-                {
-                    // receive a systematic packet
-                    // read symbol and coding coefficients into the recoder
-                    recoder.consume_symbol (rx_packet[i].packet + sizeof (uint8_t) +
-                                            IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE,
-                                            systematic_packet_coeff[*(rx_packet[i].packet + IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE)]);
-                }
-                else if (rx_packet[i].length == IPHC_TOTAL_SIZE +
-                                                UDPHC_TOTAL_SIZE +
-                                                recoder.coefficient_vector_size() +
-                                                recoder.symbol_size())
+                nc_payload = rx_packet[i] + IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE;
+                if (rx_packet_length[i] <= IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE ||
+                    parse_nc_packet (nc_payload,
+                                     rx_packet_length[i] - IPHC_TOTAL_SIZE - UDPHC_TOTAL_SIZE,
+                                     recoder->coefficient_vector_size(),
+                                     recoder->symbol_size(),
+                                     &header) == false ||
+                    header.field != field_id)
+                    continue;
+                // the relay stores a single generation
+                generation_id = header.generation_id;
+                flow_id = get_udp_flow (rx_packet[i] + IPHC_TOTAL_SIZE);
+                if ((header.flags & NC_FLAG_ROUND_END) != 0)
+                    round_end = true;
+                innovative = true;
+                switch (header.type)
                 {
-                    // receive a coded packet
-                    // read symbol and coding coefficients into the recoder
-                    recoder.consume_symbol (rx_packet[i].packet + recoder.coefficient_vector_size() +
-                                            IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE,
-                                            rx_packet[i].packet + IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE);
+                    case NC_SYSTEMATIC:
+                        innovative = track_systematic_symbol (tracker, header.index);
+                        if (innovative == true)
+                            // read symbol and coding coefficients into the recoder
+                            recoder->consume_symbol (header.symbol,
+                                                    systematic_packet_coeff[header.index]);
+                        break;
+                    case NC_CODED:
+                        innovative = track_coded_symbol (tracker, header.coefficients);
+                        if (innovative == true)
+                            recoder->consume_symbol (header.symbol, header.coefficients);
+                        break;
+                    case NC_SEEDED:
+                        // recoded packets fall back to the full coding vector
+                        generate_seeded_coefficients (coefficients,
+                                                      recoder->symbols(),
+                                                      header.seed,
+                                                      header.density,
+                                                      field_id);
+                        innovative = track_coded_symbol (tracker, coefficients);
+                        if (innovative == true)
+                            recoder->consume_symbol (header.symbol, coefficients);
+                        break;
+                    case NC_PAYLOAD:
+                        // kodo payloads can not be recoded with the symbol API, forward them as they are
+                        ret = write_relay_packet (fd, tx_packet, rx_packet[i], rx_packet_length[i], inter_frame_interval);
+                        if (ret < 0)
+                            return -1;
+                        usleep (inter_frame_interval);
+                        break;
                 }
+                if (innovative == false)
+                    dependent_packet_count++;
             }
+            // the output follows the rank gained, not the packets received
+            fwd_packet_count = get_tracked_rank (tracker) + get_tracked_rank (tracker) * (redundancy / 2);
             // generate recoded packets and forward
-            for (uint8_t i = 0; i < fwd_packet_count; i++)
+            for (uint16_t i = 0; i < fwd_packet_count; i++)
             {
-                // generate recoding coefficients
-                recoder.recoder_generate (recoder_coefficients);
-                // write an encoded symbol based on the recoding coefficients
-                recoder.recoder_produce_symbol (recoder_symbol,
-                                                recoder_symbol_coefficients,
-                                                recoder_coefficients);
-                // construct packet
-                set_ip_header (packet);
-                set_udp_header (packet + IPHC_TOTAL_SIZE);
-                memcpy (packet + IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE,
-                        recoder_symbol_coefficients,
-                        sizeof recoder_symbol_coefficients);
-                memcpy (packet + sizeof recoder_symbol_coefficients +
-                        IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE,
-                        recoder_symbol,
-                        sizeof recoder_symbol);
-                tx_packet_length = IPHC_TOTAL_SIZE +
-                                   UDPHC_TOTAL_SIZE +
-                                   sizeof recoder_symbol_coefficients +
-                                   sizeof recoder_symbol;
+                header.flags = NC_FLAG_RECODED;
+                // a rateless round buffered here ends with the last recoded packet
+                if (round_end == true && i + 1 == fwd_packet_count)
+                    header.flags |= NC_FLAG_ROUND_END;
+                header.generation_id = generation_id;
+                header.field = field_id;
+                tx_packet_length = produce_recoded_packet (recoder,
+                                                           &header,
+                                                           recoder_symbol,
+                                                           recoder_symbol_coefficients,
+                                                           recoder_coefficients,
+                                                           flow_id,
+                                                           packet);
                 // forwarding
-                generate_normal_packet (&tx_packet[0], packet, tx_packet_length);
-                ret = write_serial_port (fd, tx_packet[0].packet, tx_packet[0].length);
+                ret = write_relay_packet (fd, tx_packet, packet, tx_packet_length, inter_frame_interval);
                 if (ret < 0)
                     return -1;
+                if (first_fwd_time == 0)
+                    first_fwd_time = get_time_us ();
                 printf ("[relay] forward a packet\n");
                 usleep (inter_frame_interval);
             }
@@ -303,12 +836,16 @@ int main(int argc, char *argv[])
         else
         // recoding not enabled, just forwarding
         {
-            fwd_packet_count = rx_packet_count;
-            for (uint8_t i = 0; i < fwd_packet_count; i++)
+            fwd_packet_count = rx_packet_count < rx_packet_capacity ? rx_packet_count : rx_packet_capacity;
+            for (uint16_t i = 0; i < fwd_packet_count; i++)
             {
-                ret = write_serial_port (fd, rx_packet[i].packet, rx_packet[i].length);
+                if (rx_packet_length[i] == 0)
+                    continue;
+                ret = write_relay_packet (fd, tx_packet, rx_packet[i], rx_packet_length[i], inter_frame_interval);
                 if (ret < 0)
                     return -1;
+                if (first_fwd_time == 0)
+                    first_fwd_time = get_time_us ();
                 printf ("[relay] forward a packet\n");
                 usleep (inter_frame_interval);
             }
@@ -317,14 +854,33 @@ int main(int argc, char *argv[])
 
     printf ("[relay] packet total receive: %u\n", rx_packet_count);
     printf ("[relay] packet total forward: %u\n", fwd_packet_count);
+    if (decode_enable == true)
+        printf ("[relay] non-innovative packet total receive: %u, decoded rank %u\n", dependent_packet_count, decoder->rank ());
+    else if (recode_enable == true)
+        printf ("[relay] non-innovative packet total receive: %u, rank %u\n", dependent_packet_count, get_tracked_rank (tracker));
+    if (online_enable == true && recode_enable == true && decode_enable == false)
+        printf ("[relay] recoder cache hit: %u, miss: %u, eviction: %u\n", cache.hit_count, cache.miss_count, cache.eviction_count);
+    if (first_fwd_time > 0)
+        printf ("[relay] first packet forwarded after: %.2f ms\n", (float)(first_fwd_time - first_rx_time) / 1000);
+    if (online_enable == true || decode_enable == true)
+        printf ("[relay] coding time: %llu us\n", (unsigned long long)coding_time);
     // write log to json file
     ret = write_measurement_log (log_file_name,
-                                 &recoder,
+                                 recoder,
                                  recode_enable,
                                  rx_packet_count,
                                  fwd_packet_count,
+                                 dependent_packet_count,
+                                 decode_enable == true ? decoder->rank () : get_tracked_rank (tracker),
                                  redundancy,
-                                 sparse_enable);
+                                 sparse_enable,
+                                 online_enable,
+                                 decode_enable,
+                                 first_fwd_time > 0 ? first_fwd_time - first_rx_time : 0,
+                                 coding_time);
+    free_recoder_cache (&cache);
+    delete decoder;
+    delete encoder;
     if (ret < 0)
         return -1;
     return 0;
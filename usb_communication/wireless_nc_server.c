@@ -13,6 +13,11 @@
 #include "utils.h"
 #include "lowpan.h"
 #include "reassemble.h"
+#include "coding_vector.h"
+#include "nc_header.h"
+#include "nc_field.h"
+#include "delivery.h"
+#include "file_map.h"
 #include "config.h"
 
 #include <kodo_rlnc/coders.hpp>
@@ -30,13 +35,21 @@ static struct option long_options[] =
     {"logFile",     required_argument, 0, 'l'},
     {"density",     no_argument,       0, 'd'},
     {"recode",      no_argument,       0, 'c'},
+    {"generations", required_argument, 0, 'n'},
+    {"pipeline",    required_argument, 0, 'k'},
+    {"feedback",    required_argument, 0, 'f'},
+    {"output",      required_argument, 0, 'o'},
+    {"blockSize",   required_argument, 0, 'b'},
+    {"writeFile",   required_argument, 0, 'w'},
+    {"fileSize",    required_argument, 0, 'z'},
+    {"field",       required_argument, 0, 'F'},
     {"help",        no_argument,       0, 'h'},
     {0, 0, 0, 0}
 };
 
 void usage(void)
 {
-    printf ("Usage: [-p --port <serial port number>] [-s --symbolSize <symbol size>] [-g --genSize <generation size>] [-r --redundancy <redundancy in percent>] [-l --logFile <log file name>] [-d --density] [-c --recode] [-h --help]\n");
+    printf ("Usage: [-p --port <serial port number>] [-s --symbolSize <symbol size>] [-g --genSize <generation size>] [-r --redundancy <redundancy in percent>] [-l --logFile <log file name>] [-d --density] [-c --recode] [-n --generations <generations>] [-k --pipeline <generations in flight>] [-f --feedback <packets per rank report>] [-o --output <file or pipe>] [-b --blockSize <bytes per generation>] [-w --writeFile <file>] [-z --fileSize <bytes>] [-F --field <finite field>] [-h --help]\n");
     printf ("Options:\n");
     printf ("\t-p --port\tserial port number to open\tDefault: /dev/ttyACM0\n");
     printf ("\t-s --symbolSize\tsymbol size\t\t\tDefault: 4\n");
@@ -45,14 +58,56 @@ void usage(void)
     printf ("\t-l --logFile\tlog file name\t\t\tDefault: log.dump\n");
     printf ("\t-d --density\tenable sparse coding\n");
     printf ("\t-c --recode\tenable recoding in relay\n");
+    printf ("\t-n --generations\tgenerations to receive\tDefault: 1\n");
+    printf ("\t-k --pipeline\tgenerations decoded at once\tDefault: 1\n");
+    printf ("\t-f --feedback\treport rank to the client every n packets\tDefault: 0 (off)\n");
+    printf ("\t-o --output\tstream decoded symbols in order to a file or pipe\tDefault: off\n");
+    printf ("\t-b --blockSize\tbytes per generation, the last symbol is trimmed on output\tDefault: genSize * symbolSize\n");
+    printf ("\t-w --writeFile\tdecode a file transfer into this file, overrides the generation number\n");
+    printf ("\t-z --fileSize\tsize of the transferred file in bytes, needed with -w\n");
+    printf ("\t-F --field\tbinary, binary4, binary8, binary16 or prime2325, must match the client\tDefault: binary8\n");
     printf ("\t-h --help\tthis help documetation\n");
 }
 
+typedef struct
+{
+    kodo_rlnc::decoder* decoder;
+    uint8_t* data_out;          // decoder storage, in the output file mapping for a full block
+    uint8_t* block_buffer;      // owned storage for generations not decoded into the mapping
+    uint8_t* file_block;        // block of the generation in the output file, NULL without one
+    uint32_t block_length;      // source bytes of the generation
+    uint32_t generation_number; // generation id without wrap around
+    uint8_t generation_id;
+    uint16_t rx_packet_count;
+    clock_t last_rx_time;
+    uint8_t* payload_data;      // payloads stored for the batch payload API
+    uint8_t** payloads;
+    uint16_t payload_num;
+    uint16_t payload_size;
+    bool batch_failed;          // batch was rank deficient, payloads are consumed one by one
+    uint16_t delivered_num;     // symbols streamed to the delivery sink
+    uint64_t first_rx_time;     // us
+    uint64_t first_delivery_time; // us
+    uint64_t total_delivery_delay; // us, summed over delivered symbols
+    bool active;
+} decoder_slot_t;
+
+// recently retired generations, late packets of them are ignored
+typedef struct
+{
+    uint8_t ids[2 * MAX_PIPELINE_SIZE];
+    bool decoded[2 * MAX_PIPELINE_SIZE];
+    uint8_t num;
+    uint8_t cursor;
+} retired_history_t;
+
 void print_nc_config (kodo_rlnc::decoder* decoder,
-                      float redundancy)
+                      float redundancy,
+                      uint8_t field_id)
 {
     // print configuration
     printf ("---------NC configuration---------\n");
+    printf ("finite field:\t\t\t%s\n", get_field_name (field_id));
     printf ("decoder symbol size:\t\t%u\n", decoder->symbol_size());
     printf ("decoder coeff vector size:\t%u\n", decoder->coefficient_vector_size());
     printf ("decoder payload size:\t\t%u\n", decoder->max_payload_size());
@@ -62,6 +117,7 @@ void print_nc_config (kodo_rlnc::decoder* decoder,
 
 int write_measurement_log (char* log_file_name,
                            kodo_rlnc::decoder* decoder,
+                           uint8_t generation_id,
                            float redundancy,
                            bool sparse_enable,
                            bool recode_enable)
@@ -78,19 +134,22 @@ int write_measurement_log (char* log_file_name,
         loss_rate = (float)(decoder->symbols() - decoder->rank()) / decoder->symbols();
 
     if (sparse_enable == true)
-        fprintf(fp, "{\"type\": \"block_sparse\", \"gen_size\": %u, \"redundancy\": %.2f, \"loss_rate\": %.2f, \"tx_num\": %u },\n",
+        fprintf(fp, "{\"type\": \"block_sparse\", \"generation\": %u, \"gen_size\": %u, \"redundancy\": %.2f, \"loss_rate\": %.2f, \"tx_num\": %u },\n",
+            generation_id,
             decoder->symbols(),
             redundancy,
             loss_rate,
             (unsigned)(decoder->symbols() * (1 + redundancy)));
     else if (recode_enable == true)
-        fprintf(fp, "{\"type\": \"block_recode\", \"gen_size\": %u, \"redundancy\": %.2f, \"loss_rate\": %.2f, \"tx_num\": %u },\n",
+        fprintf(fp, "{\"type\": \"block_recode\", \"generation\": %u, \"gen_size\": %u, \"redundancy\": %.2f, \"loss_rate\": %.2f, \"tx_num\": %u },\n",
+            generation_id,
             decoder->symbols(),
             redundancy,
             loss_rate,
             (unsigned)(decoder->symbols() * (1 + redundancy / 2)));
     else
-        fprintf(fp, "{\"type\": \"block_full\", \"gen_size\": %u, \"redundancy\": %.2f, \"loss_rate\": %.2f, \"tx_num\": %u },\n",
+        fprintf(fp, "{\"type\": \"block_full\", \"generation\": %u, \"gen_size\": %u, \"redundancy\": %.2f, \"loss_rate\": %.2f, \"tx_num\": %u },\n",
+            generation_id,
             decoder->symbols(),
             redundancy,
             loss_rate,
@@ -100,6 +159,255 @@ int write_measurement_log (char* log_file_name,
     return 0;
 }
 
+/**
+ * @brief get wall clock time in us
+ */
+uint64_t get_time_us (void)
+{
+    struct timeval now;
+    gettimeofday (&now, NULL);
+    return 1000000 * (uint64_t)now.tv_sec + now.tv_usec;
+}
+
+/**
+ * @brief write the streaming delivery latency of a generation
+ */
+int write_delivery_log (char* log_file_name, decoder_slot_t* slot, uint64_t retire_time)
+{
+    FILE* fp;
+    fp = fopen (log_file_name, "a+");
+    if (fp == NULL)
+    {
+        fprintf (stderr, "error %d opening %s: %s\n", errno, log_file_name, strerror (errno));
+        return -1;
+    }
+
+    fprintf(fp, "{\"type\": \"stream_delivery\", \"generation\": %u, \"gen_size\": %u, \"delivered_num\": %u, \"first_symbol_ms\": %.2f, \"avg_symbol_ms\": %.2f, \"retire_ms\": %.2f },\n",
+            slot->generation_id,
+            slot->decoder->symbols(),
+            slot->delivered_num,
+            slot->delivered_num > 0 ? (float)(slot->first_delivery_time - slot->first_rx_time) / 1000 : 0,
+            slot->delivered_num > 0 ? (float)slot->total_delivery_delay / slot->delivered_num / 1000 : 0,
+            (float)(retire_time - slot->first_rx_time) / 1000);
+    fclose(fp);
+    return 0;
+}
+
+/**
+ * @brief stream the symbols that are decoded together with all symbols before them,
+ *        return -1 on sink failure
+ */
+int deliver_decoded_symbols (decoder_slot_t* slot, delivery_sink_t* sink)
+{
+    kodo_rlnc::decoder* decoder = slot->decoder;
+    uint16_t length;
+    uint64_t now_time;
+
+    while (slot->delivered_num < decoder->symbols() &&
+           (decoder->is_complete() == true ||
+            decoder->is_symbol_decoded (slot->delivered_num) == true))
+    {
+        // the last source symbols only carry the rest of the block
+        length = get_block_symbol_length (slot->block_length,
+                                          slot->delivered_num,
+                                          decoder->symbol_size());
+        if (length > 0 &&
+            deliver_symbol (sink,
+                            slot->generation_id,
+                            slot->delivered_num,
+                            slot->data_out + slot->delivered_num * decoder->symbol_size(),
+                            length) < 0)
+            return -1;
+        now_time = get_time_us ();
+        if (slot->delivered_num == 0)
+            slot->first_delivery_time = now_time;
+        slot->total_delivery_delay += now_time - slot->first_rx_time;
+        slot->delivered_num++;
+    }
+    return 0;
+}
+
+/**
+ * @brief print every symbol handed to the delivery sink
+ */
+void print_delivered_symbol (uint8_t generation_id,
+                             uint16_t index,
+                             const uint8_t* symbol,
+                             uint16_t length,
+                             void* context)
+{
+    printf ("[server] deliver generation %u symbol %u\n", generation_id, index);
+}
+
+/**
+ * @brief feed stored payloads one by one, after a rank deficient batch
+ */
+void consume_stored_payloads (decoder_slot_t* slot)
+{
+    for (uint16_t i = 0; i < slot->payload_num; i++)
+        slot->decoder->consume_payload (slot->payloads[i]);
+    slot->payload_num = 0;
+    slot->batch_failed = true;
+}
+
+/**
+ * @brief store a payload of the batch payload API, decode the batch once it can reach full rank
+ */
+void consume_batch_payload (decoder_slot_t* slot, uint8_t* payload, uint16_t length)
+{
+    if (length > slot->payload_size)
+        return;
+    if (slot->batch_failed == true)
+    {
+        slot->decoder->consume_payload (payload);
+        return;
+    }
+    memcpy (slot->payloads[slot->payload_num], payload, length);
+    slot->payload_num++;
+    // a batch is decoded at once and only when it is full rank
+    if (slot->payload_num < slot->decoder->symbols())
+        return;
+    if (slot->decoder->consume_payloads (slot->payloads, slot->payload_num) == true)
+        slot->payload_num = 0;
+    else
+        consume_stored_payloads (slot);
+}
+
+/**
+ * @brief get decoder rank, payloads waiting for a batch count as innovative
+ */
+uint32_t get_slot_rank (decoder_slot_t* slot)
+{
+    return slot->decoder->rank() + slot->payload_num;
+}
+
+/**
+ * @brief find the decoder slot of a generation in flight, return NULL if not found
+ */
+decoder_slot_t* find_generation_slot (decoder_slot_t* pool, uint8_t pool_size, uint8_t generation_id)
+{
+    for (uint8_t k = 0; k < pool_size; k++)
+        if (pool[k].active == true && pool[k].generation_id == generation_id)
+            return &pool[k];
+    return NULL;
+}
+
+/**
+ * @brief find the generation in flight that comes first from the given one on,
+ *        return NULL if the pool is empty
+ */
+decoder_slot_t* find_oldest_slot (decoder_slot_t* pool, uint8_t pool_size, uint8_t generation_id)
+{
+    decoder_slot_t* oldest = NULL;
+    for (uint8_t k = 0; k < pool_size; k++)
+        if (pool[k].active == true &&
+            (oldest == NULL ||
+             (uint8_t)(pool[k].generation_id - generation_id) < (uint8_t)(oldest->generation_id - generation_id)))
+            oldest = &pool[k];
+    return oldest;
+}
+
+/**
+ * @brief find a recently retired generation, return -1 if not found
+ */
+int16_t find_retired_generation (retired_history_t* history, uint8_t generation_id)
+{
+    for (uint8_t i = 0; i < history->num; i++)
+        if (history->ids[i] == generation_id)
+            return i;
+    return -1;
+}
+
+/**
+ * @brief remember a generation leaving the decoder pool
+ */
+void add_retired_generation (retired_history_t* history, uint8_t generation_id, bool decoded)
+{
+    history->ids[history->cursor] = generation_id;
+    history->decoded[history->cursor] = decoded;
+    history->cursor = (history->cursor + 1) % (2 * MAX_PIPELINE_SIZE);
+    if (history->num < 2 * MAX_PIPELINE_SIZE)
+        history->num++;
+}
+
+/**
+ * @brief hand the stream over to the next generation that is not retired yet
+ */
+void advance_stream_head (retired_history_t* history, delivery_sink_t* sink)
+{
+    do
+        sink->head_generation++;
+    while (find_retired_generation (history, sink->head_generation) >= 0);
+}
+
+/**
+ * @brief skip stream heads without a slot while younger generations are in flight,
+ *        a generation lost entirely leaves a gap in the stream but keeps the order,
+ *        return the number of generations skipped
+ */
+uint16_t skip_lost_generations (decoder_slot_t* pool,
+                                uint8_t pool_size,
+                                retired_history_t* history,
+                                delivery_sink_t* sink)
+{
+    uint16_t skip_num = 0;
+    while (find_generation_slot (pool, pool_size, sink->head_generation) == NULL &&
+           find_oldest_slot (pool, pool_size, sink->head_generation) != NULL)
+    {
+        printf ("[server] generation %u lost, skipped in the stream\n", sink->head_generation);
+        add_retired_generation (history, sink->head_generation, false);
+        advance_stream_head (history, sink);
+        skip_num++;
+    }
+    return skip_num;
+}
+
+/**
+ * @brief report a generation leaving the decoder pool and free its slot
+ */
+int retire_generation (decoder_slot_t* slot,
+                       retired_history_t* history,
+                       delivery_sink_t* sink,
+                       char* log_file_name,
+                       float redundancy,
+                       bool sparse_enable,
+                       bool recode_enable)
+{
+    // payloads short of a full batch still count
+    if (slot->payload_num > 0)
+        consume_stored_payloads (slot);
+    // a short block was decoded aside, the mapping may end before a full block
+    if (slot->file_block != NULL && slot->file_block != slot->data_out)
+        memcpy (slot->file_block, slot->data_out, slot->block_length);
+    if (is_delivery_sink_open (sink) == true)
+    {
+        // symbols after the first undecoded one can not be delivered in order,
+        // generations leave the pool in stream order while a sink is open
+        if (deliver_decoded_symbols (slot, sink) < 0 ||
+            write_delivery_log (log_file_name, slot, get_time_us ()) < 0)
+            return -1;
+        printf ("[server] generation %u symbol deliver: %u\n", slot->generation_id, slot->delivered_num);
+    }
+    print_payload (slot->data_out, slot->decoder->block_size());
+    if (slot->decoder->is_complete() == true)
+        printf ("[server] generation %u decode complete!\n", slot->generation_id);
+    else
+        printf ("[server] generation %u decode failure!\n", slot->generation_id);
+    printf ("[server] generation %u decoder rank: %u\n", slot->generation_id, slot->decoder->rank());
+    printf ("[server] generation %u packet receive: %u\n", slot->generation_id, slot->rx_packet_count);
+    slot->active = false;
+    add_retired_generation (history, slot->generation_id, slot->decoder->is_complete());
+    if (slot->generation_id == sink->head_generation)
+        advance_stream_head (history, sink);
+    // write log to json file
+    return write_measurement_log (log_file_name,
+                                  slot->decoder,
+                                  slot->generation_id,
+                                  redundancy,
+                                  sparse_enable,
+                                  recode_enable);
+}
+
 int main(int argc, char *argv[])
 {
     char* serial_port = (char*)USB_DEVICE;
@@ -109,12 +417,20 @@ int main(int argc, char *argv[])
     float redundancy = 0.2;
     bool sparse_enable = false;
     bool recode_enable = false;
+    uint16_t generation_num = 1;
+    uint32_t pipeline_size = 1;
+    uint16_t feedback_interval = 0;
+    char* output_file_name = NULL;
+    uint32_t block_length = 0;
+    char* write_file_name = NULL;
+    uint64_t file_size = 0;
+    uint8_t field_id = NC_FIELD_DEFAULT;
 
     // cmd arguments parsing
     int opt;
     int option_index = 0;
 
-    while ((opt = getopt_long (argc, argv, "p:s:g:r:l:dch", long_options, &option_index)) != -1)
+    while ((opt = getopt_long (argc, argv, "p:s:g:r:l:dcn:k:f:o:b:w:z:F:h", long_options, &option_index)) != -1)
     {
         switch (opt)
         {
@@ -139,6 +455,34 @@ int main(int argc, char *argv[])
             case 'c':
                 recode_enable = true;
                 break;
+            case 'n':
+                generation_num = atoi (optarg);
+                break;
+            case 'k':
+                pipeline_size = atoi (optarg);
+                break;
+            case 'f':
+                feedback_interval = atoi (optarg);
+                break;
+            case 'o':
+                output_file_name = optarg;
+                break;
+            case 'b':
+                block_length = atoi (optarg);
+                break;
+            case 'w':
+                write_file_name = optarg;
+                break;
+            case 'z':
+                file_size = strtoull (optarg, NULL, 10);
+                break;
+            case 'F':
+                if (parse_field_name (optarg, &field_id) == false)
+                {
+                    fprintf (stderr, "unknown finite field %s\n", optarg);
+                    return -1;
+                }
+                break;
             case 'h':
                 usage ();
                 return 0;
@@ -159,91 +503,321 @@ int main(int argc, char *argv[])
         return -1;
     }
 
+    if (pipeline_size < 1)
+        pipeline_size = 1;
+    if (pipeline_size > MAX_PIPELINE_SIZE)
+        pipeline_size = MAX_PIPELINE_SIZE;
+
     int ret;
     int rx_num = 0;
     uint16_t rx_packet_count = 0;
     uint16_t rx_frame_count = 0;
     uint8_t extract_buf[MAX_PACKET_SIZE];
     memset (extract_buf, 0, sizeof extract_buf);
+    uint8_t* nc_payload = extract_buf + IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE;
+    nc_header_t header;
+    uint8_t generation_id = 0;
+    uint8_t ack_packet[CONTROL_MAX_SIZE];
+    uint8_t ack_packet_length = 0;
 
     // time related variable definition
     clock_t rx_timeout_start = 0;
     uint32_t rx_timeout = 1000; // ms, hard coded
+    uint32_t generation_timeout = 1000; // ms, hard coded
 
     // decoder initialization
     // set finite field size
-    fifi::finite_field field = fifi::finite_field::binary8;
-    // create an decoder
-    kodo_rlnc::decoder decoder (field, generation_size, symbol_size);
-
-    // set buffers
-    uint8_t data_out[decoder.block_size()];
-    memset (data_out, 0, sizeof data_out);
-    // assign source data buffer to encoder
-    decoder.set_symbols_storage (data_out);
-
-    // set ack message buffer
-    virtual_packet_t ack_buf;
-    uint8_t ack_packet[MAX_SIZE];
-    memset (ack_packet, 0, sizeof ack_packet);
-    memset (&ack_buf, 0, sizeof ack_buf);
-    // construct ack packet
-    uint8_t ack_packet_length = generate_ack_packet (ack_packet, (uint8_t*)SERVER_ACK);
-    generate_normal_packet (&ack_buf, ack_packet, ack_packet_length);
-
-    print_nc_config (&decoder, redundancy);
+    fifi::finite_field field = (fifi::finite_field)field_id;
+    // create a decoder pool, decoders are reset instead of rebuilt for every generation
+    decoder_slot_t decoder_pool[pipeline_size];
+    memset (decoder_pool, 0, sizeof decoder_pool);
+    for (uint8_t k = 0; k < pipeline_size; k++)
+    {
+        decoder_pool[k].decoder = new kodo_rlnc::decoder (field, generation_size, symbol_size);
+        decoder_pool[k].block_buffer = new uint8_t[decoder_pool[k].decoder->block_size()];
+        // a sparse seed payload also carries its density
+        decoder_pool[k].payload_size = decoder_pool[k].decoder->max_payload_size() + sizeof (float);
+        decoder_pool[k].payload_data = new uint8_t[generation_size * decoder_pool[k].payload_size];
+        decoder_pool[k].payloads = new uint8_t*[generation_size];
+        for (uint16_t i = 0; i < generation_size; i++)
+            decoder_pool[k].payloads[i] = decoder_pool[k].payload_data + i * decoder_pool[k].payload_size;
+    }
+    kodo_rlnc::decoder* decoder = decoder_pool[0].decoder;
+    if (block_length == 0 || block_length > decoder->block_size())
+        block_length = decoder->block_size();
+    if (block_length <= (generation_size - 1) * symbol_size)
+    {
+        fprintf (stderr, "block size %u leaves the last symbol empty\n", block_length);
+        return -1;
+    }
+    // file transfer, generations are decoded into a mapping of the output file
+    file_map_t output_map;
+    file_map_t* output = NULL;
+    if (write_file_name != NULL)
+    {
+        if (file_size == 0)
+        {
+            fprintf (stderr, "the size of %s is needed, set it with -z\n", write_file_name);
+            return -1;
+        }
+        if (map_output_file (&output_map, write_file_name, file_size) < 0)
+            return -1;
+        output = &output_map;
+        if (get_file_block_num (output, block_length) > UINT16_MAX)
+        {
+            fprintf (stderr, "%s needs more than %u generations\n", write_file_name, UINT16_MAX);
+            return -1;
+        }
+        generation_num = get_file_block_num (output, block_length);
+        printf ("output %s: %llu bytes in %u generations\n",
+                write_file_name,
+                (unsigned long long)output->size,
+                generation_num);
+    }
+    // streaming delivery of decoded symbols
+    delivery_sink_t sink;
+    if (open_delivery_sink (&sink, output_file_name) < 0)
+        return -1;
+    if (output_file_name != NULL)
+        set_delivery_callback (&sink, print_delivered_symbol, NULL);
+    decoder_slot_t* slot = NULL;
+    uint16_t retired_generation_num = 0;
+    uint16_t decoded_generation_num = 0;
+    retired_history_t retired_history;
+    memset (&retired_history, 0, sizeof retired_history);
+    int16_t retired_index = -1;
+    int64_t generation_number = 0;
+    uint32_t newest_generation = 0; // generation number of the newest generation seen
+    uint8_t coefficients[decoder->coefficient_vector_size()];
+
+    print_nc_config (decoder, redundancy, field_id);
 
     rx_timeout_start = clock();
     // server operations
-    while (decoder.is_complete() == false)
+    while (retired_generation_num < generation_num)
     {
+        // generations decoded ahead of the stream follow once it reaches them
+        while ((slot = find_generation_slot (decoder_pool, pipeline_size, sink.head_generation)) != NULL &&
+               slot->decoder->is_complete() == true)
+        {
+            ret = retire_generation (slot, &retired_history, &sink, log_file_name, redundancy, sparse_enable, recode_enable);
+            if (ret < 0)
+                return -1;
+            retired_generation_num++;
+            decoded_generation_num++;
+        }
         if ((clock() - rx_timeout_start) * 1000 / CLOCKS_PER_SEC > rx_timeout)
             break;
+        // retire generations without progress, decoded ones wait for the stream,
+        // and so do younger ones while streaming
+        for (uint8_t k = 0; k < pipeline_size; k++)
+        {
+            slot = &decoder_pool[k];
+            if (slot->active == false ||
+                slot->decoder->is_complete() == true ||
+                (is_delivery_sink_open (&sink) == true && slot->generation_id != sink.head_generation) ||
+                (clock() - slot->last_rx_time) * 1000 / CLOCKS_PER_SEC <= generation_timeout)
+                continue;
+            retire_generation (slot, &retired_history, &sink, log_file_name, redundancy, sparse_enable, recode_enable);
+            retired_generation_num++;
+        }
+        // a generation lost entirely never gets a slot, the stream skips it
+        // once a younger generation waited a generation timeout for it
+        slot = find_oldest_slot (decoder_pool, pipeline_size, sink.head_generation);
+        if (slot != NULL &&
+            slot->generation_id != sink.head_generation &&
+            get_time_us () - slot->first_rx_time > (uint64_t)generation_timeout * 1000)
+            retired_generation_num += skip_lost_generations (decoder_pool, pipeline_size, &retired_history, &sink);
         // receive a packet
         rx_num = read_serial_port (fd, extract_buf, &rx_frame_count, false);
-        if (rx_num == 0)
+        if (rx_num <= IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE ||
+            parse_nc_packet (nc_payload,
+                             rx_num - IPHC_TOTAL_SIZE - UDPHC_TOTAL_SIZE,
+                             decoder->coefficient_vector_size(),
+                             decoder->symbol_size(),
+                             &header) == false)
+            continue;
+        // coefficients of another field would decode to garbage
+        if (header.field != field_id)
+        {
+            printf ("[server] drop a packet coded over %s\n", get_field_name (header.field));
+            memset (extract_buf, 0, sizeof extract_buf);
             continue;
-        if ((unsigned)rx_num == IPHC_TOTAL_SIZE +
-                                     UDPHC_TOTAL_SIZE +
-                                     decoder.coefficient_vector_size() +
-                                     decoder.symbol_size())
-        // receive a coded packet
+        }
+        rx_timeout_start = clock();
+        generation_id = header.generation_id;
+
+        // late packet of a retired generation
+        retired_index = find_retired_generation (&retired_history, generation_id);
+        if (retired_index >= 0)
         {
-            print_payload (extract_buf, rx_num);
-            // read symbol and coding coefficients into the decoder
-            decoder.consume_symbol (extract_buf + decoder.coefficient_vector_size() +
-                                    IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE,
-                                    extract_buf + IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE);
-            rx_packet_count++;
+            // the completion ack may have been lost
+            if (retired_history.decoded[retired_index] == true)
+            {
+                ack_packet_length = generate_ack_packet (ack_packet, CONTROL_GENERATION_ACK, generation_id);
+                ret = write_serial_port (fd, ack_packet, ack_packet_length);
+                if (ret < 0)
+                    return -1;
+            }
+            memset (extract_buf, 0, sizeof extract_buf);
+            continue;
         }
-        else if ((unsigned)rx_num == IPHC_TOTAL_SIZE +
-                                     UDPHC_TOTAL_SIZE +
-                                     sizeof (uint8_t) +
-                                     decoder.symbol_size())
-        // receive a systematic packet
+
+        // find the decoder of this generation
+        slot = find_generation_slot (decoder_pool, pipeline_size, generation_id);
+        // or take a free decoder, the oldest generation is retired if none is free
+        if (slot == NULL)
         {
-            decoder.consume_systematic_symbol
-                (extract_buf + IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE + sizeof (uint8_t),
-                *(extract_buf + IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE));
-            rx_packet_count++;
+            for (uint8_t k = 0; k < pipeline_size; k++)
+                if (decoder_pool[k].active == false)
+                {
+                    slot = &decoder_pool[k];
+                    break;
+                }
+            if (slot == NULL)
+            {
+                // the pool can not wait for a lost generation, the oldest in
+                // stream order is retired so the stream stays in order
+                retired_generation_num += skip_lost_generations (decoder_pool, pipeline_size, &retired_history, &sink);
+                slot = find_oldest_slot (decoder_pool, pipeline_size, sink.head_generation);
+                retire_generation (slot, &retired_history, &sink, log_file_name, redundancy, sparse_enable, recode_enable);
+                retired_generation_num++;
+                if (slot->decoder->is_complete() == true)
+                    decoded_generation_num++;
+            }
+            // generation ids wrap around, generations in flight are close to the newest one
+            generation_number = (int64_t)newest_generation + (int8_t)(generation_id - (uint8_t)newest_generation);
+            if (generation_number < 0)
+                generation_number = generation_id;
+            if (generation_number > newest_generation)
+                newest_generation = generation_number;
+            slot->generation_number = generation_number;
+            slot->block_length = block_length;
+            slot->file_block = NULL;
+            slot->data_out = slot->block_buffer;
+            if (output != NULL)
+            {
+                slot->block_length = get_file_block_length (output, slot->generation_number, block_length);
+                if (slot->block_length > 0)
+                    slot->file_block = output->data + (uint64_t)slot->generation_number * block_length;
+                // a full block is decoded straight into the file mapping
+                if (slot->block_length == slot->decoder->block_size())
+                    slot->data_out = slot->file_block;
+            }
+            slot->decoder->reset ();
+            memset (slot->data_out, 0, slot->decoder->block_size());
+            // assign source data buffer to decoder
+            slot->decoder->set_symbols_storage (slot->data_out);
+            slot->generation_id = generation_id;
+            slot->rx_packet_count = 0;
+            slot->payload_num = 0;
+            slot->batch_failed = false;
+            slot->delivered_num = 0;
+            slot->first_rx_time = get_time_us ();
+            slot->total_delivery_delay = 0;
+            // track symbols that become decoded during elimination, not only at the end
+            if (is_delivery_sink_open (&sink) == true)
+                slot->decoder->set_status_updater_on ();
+            slot->active = true;
+        }
+        slot->last_rx_time = clock();
+        decoder = slot->decoder;
+
+        switch (header.type)
+        {
+            case NC_SYSTEMATIC:
+                if (header.index >= decoder->symbols())
+                    break;
+                decoder->consume_systematic_symbol (header.symbol, header.index);
+                break;
+            case NC_CODED:
+                print_payload (extract_buf, rx_num);
+                // read symbol and coding coefficients into the decoder
+                decoder->consume_symbol (header.symbol, header.coefficients);
+                break;
+            case NC_SEEDED:
+                generate_seeded_coefficients (coefficients,
+                                              decoder->symbols(),
+                                              header.seed,
+                                              header.density,
+                                              field_id);
+                decoder->consume_symbol (header.symbol, coefficients);
+                break;
+            case NC_PAYLOAD:
+                consume_batch_payload (slot, header.symbol, header.length);
+                break;
         }
+        slot->rx_packet_count++;
+        rx_packet_count++;
         memset (extract_buf, 0, sizeof extract_buf);
-    } // end of while
 
-    print_payload (data_out, sizeof data_out);
+        // stream the oldest generation, younger ones wait for their turn
+        if (is_delivery_sink_open (&sink) == true &&
+            slot->generation_id == sink.head_generation &&
+            deliver_decoded_symbols (slot, &sink) < 0)
+            return -1;
 
-    if (decoder.is_complete() == true)
-        printf ("[server] decode complete!\n");
-    else
-        printf ("[server] decode failure!\n");
+        // report progress so the client can adapt its redundancy,
+        // or send the rank deficit at the end of a rateless round,
+        // the received packets saturate at the one byte they are reported in
+        if (decoder->is_complete() == false &&
+            ((header.flags & NC_FLAG_ROUND_END) != 0 ||
+             (feedback_interval > 0 && slot->rx_packet_count % feedback_interval == 0)))
+        {
+            ack_packet_length = build_control_frame (ack_packet,
+                                                     CONTROL_RANK_REPORT,
+                                                     generation_id,
+                                                     (uint16_t)(get_slot_rank (slot) << 8) |
+                                                     (slot->rx_packet_count > 255 ? 255 : slot->rx_packet_count));
+            ret = write_serial_port (fd, ack_packet, ack_packet_length);
+            if (ret < 0)
+                return -1;
+        }
+
+        // retire a decoded generation and tell the client,
+        // a generation decoded ahead of the stream keeps its slot until its turn
+        if (decoder->is_complete() == true)
+        {
+            ack_packet_length = generate_ack_packet (ack_packet, CONTROL_GENERATION_ACK, generation_id);
+            ret = write_serial_port (fd, ack_packet, ack_packet_length);
+            if (ret < 0)
+                return -1;
+            if (is_delivery_sink_open (&sink) == true && generation_id != sink.head_generation)
+                continue;
+            ret = retire_generation (slot, &retired_history, &sink, log_file_name, redundancy, sparse_enable, recode_enable);
+            if (ret < 0)
+                return -1;
+            retired_generation_num++;
+            decoded_generation_num++;
+        }
+    } // end of while
 
-    printf ("[server] decoder rank: %u\n", decoder.rank());
+    // generations still in flight are failures unless they wait for the stream,
+    // retire them in stream order
+    while ((slot = find_oldest_slot (decoder_pool, pipeline_size, sink.head_generation)) != NULL)
+    {
+        retired_generation_num += skip_lost_generations (decoder_pool, pipeline_size, &retired_history, &sink);
+        retire_generation (slot, &retired_history, &sink, log_file_name, redundancy, sparse_enable, recode_enable);
+        retired_generation_num++;
+        if (slot->decoder->is_complete() == true)
+            decoded_generation_num++;
+    }
+
+    printf ("[server] generation total decode: %u/%u\n", decoded_generation_num, retired_generation_num);
     printf ("[server] packet total receive: %u\n", rx_packet_count);
     printf ("[server] frame total receive: %u\n", rx_frame_count);
+    if (is_delivery_sink_open (&sink) == true)
+        printf ("[server] symbol total deliver: %u (%llu bytes)\n", sink.symbol_num, (unsigned long long)sink.byte_num);
+    close_delivery_sink (&sink);
+    if (output != NULL)
+        unmap_file (output);
 
-    // write log to json file
-    ret = write_measurement_log (log_file_name, &decoder, redundancy, sparse_enable, recode_enable);
-    if (ret < 0)
-        return -1;
+    for (uint8_t k = 0; k < pipeline_size; k++)
+    {
+        delete decoder_pool[k].decoder;
+        delete[] decoder_pool[k].block_buffer;
+        delete[] decoder_pool[k].payload_data;
+        delete[] decoder_pool[k].payloads;
+    }
     return 0;
 }
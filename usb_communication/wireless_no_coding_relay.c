@@ -134,12 +134,10 @@ int main(int argc, char *argv[])
     memset (data_out, 0, sizeof data_out);
 
     // set ack message buffer
-    virtual_packet_t ack_buf;
     uint8_t ack_packet[MAX_SIZE];
     memset (ack_packet, 0, sizeof ack_packet);
-    memset (&ack_buf, 0, sizeof ack_buf);
     // construct ack packet
-    uint8_t ack_packet_length = generate_ack_packet (ack_packet, (uint8_t*)RELAY_ACK);
+    uint8_t ack_packet_length = generate_ack_packet (ack_packet, RELAY_ACK, 0);
 
     // create a forwarder
     lowpan_forwarder_t forwarder;
@@ -155,7 +153,7 @@ int main(int argc, char *argv[])
         {
             // receive an ack means a frame is successfully forwarded
             // reset forwarder
-            if (is_ack_packet (extract_buf) == true)
+            if (is_ack_packet (extract_buf, rx_num) == true)
             {
                 printf ("[relay] forward a frame\n");
                 forwarder.idle = true;
@@ -137,14 +137,6 @@ int main(int argc, char *argv[])
     virtual_packet_t tx_packet[MAX_FRAG_NUM];
     memset (tx_packet, 0, sizeof (virtual_packet_t) * MAX_FRAG_NUM);
 
-    // set ack message buffer
-    virtual_packet_t ack_buf;
-    uint8_t ack_packet[MAX_SIZE];
-    memset (ack_packet, 0, sizeof ack_packet);
-    memset (&ack_buf, 0, sizeof ack_buf);
-    // construct ack packet
-    uint8_t ack_packet_length = generate_ack_packet (ack_packet, (uint8_t*)RELAY_ACK);
-
     rx_timeout_start = clock();
     // relay operations
     while ((clock() - rx_timeout_start) * 1000 / CLOCKS_PER_SEC < rx_timeout)
@@ -134,15 +134,6 @@ int main(int argc, char *argv[])
     uint8_t data_out[symbol_size * generation_size];
     memset (data_out, 0, sizeof data_out);
 
-    // set ack message buffer
-    virtual_packet_t ack_buf;
-    uint8_t ack_packet[MAX_SIZE];
-    memset (ack_packet, 0, sizeof ack_packet);
-    memset (&ack_buf, 0, sizeof ack_buf);
-    // construct ack packet
-    uint8_t ack_packet_length = generate_ack_packet (ack_packet, (uint8_t*)SERVER_ACK);
-    generate_normal_packet (&ack_buf, ack_packet, ack_packet_length);
-
     rx_timeout_start = clock();
     // server operations
     while (rx_packet_count < generation_size)
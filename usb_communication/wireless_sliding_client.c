@@ -0,0 +1,315 @@
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <stdint.h>
+#include <sys/time.h>
+#include <time.h>
+#include <stdlib.h>
+
+#include "serial.h"
+#include "utils.h"
+#include "lowpan.h"
+#include "reassemble.h"
+#include "sliding_window.h"
+#include "config.h"
+
+#define USB_DEVICE  "/dev/ttyACM0"
+#define LOG_FILE    "log.dump"
+#define MAX_SIZE    128
+
+static struct option long_options[] =
+{
+    {"port",        required_argument, 0, 'p'},
+    {"symbolSize",  required_argument, 0, 's'},
+    {"window",      required_argument, 0, 'w'},
+    {"symbols",     required_argument, 0, 'n'},
+    {"redundancy",  required_argument, 0, 'r'},
+    {"timeout",     required_argument, 0, 't'},
+    {"logFile",     required_argument, 0, 'l'},
+    {"help",        no_argument,       0, 'h'},
+    {0, 0, 0, 0}
+};
+
+void usage(void)
+{
+    printf ("Usage: [-p --port <serial port number>] [-s --symbolSize <symbol size>] [-w --window <window size>] [-n --symbols <source symbols>] [-r --redundancy <redundancy in percent>] [-t --timeout <ack timeout in ms>] [-l --logFile <log file name>] [-h --help]\n");
+    printf ("Options:\n");
+    printf ("\t-p --port\tserial port number to open\tDefault: /dev/ttyACM0\n");
+    printf ("\t-s --symbolSize\tsymbol size\t\t\tDefault: 4\n");
+    printf ("\t-w --window\tmaximum window size\t\tDefault: 8\n");
+    printf ("\t-n --symbols\tsource symbols to stream\tDefault: 100\n");
+    printf ("\t-r --redundancy\trepair symbols in percent\tDefault: 20\n");
+    printf ("\t-t --timeout\tabort without ack progress in ms\tDefault: 1000\n");
+    printf ("\t-l --logFile\tlog file name\t\t\tDefault: log.dump\n");
+    printf ("\t-h --help\tthis help documetation\n");
+}
+
+int write_measurement_log (char* log_file_name,
+                           sliding_encoder_t* encoder,
+                           float redundancy,
+                           uint16_t symbol_num,
+                           uint16_t acked_num,
+                           uint16_t tx_packet_count,
+                           uint16_t repair_count,
+                           uint64_t total_latency,
+                           uint64_t max_latency)
+{
+    FILE* fp;
+    fp = fopen (log_file_name, "a+");
+    if (fp == NULL)
+    {
+        fprintf (stderr, "error %d opening %s: %s\n", errno, log_file_name, strerror (errno));
+        return -1;
+    }
+
+    fprintf(fp, "{\"type\": \"sliding_window\", \"window_size\": %u, \"symbol_size\": %u, \"redundancy\": %.2f, \"source_num\": %u, \"acked_num\": %u, \"tx_num\": %u, \"repair_num\": %u, \"avg_latency_ms\": %.2f, \"max_latency_ms\": %.2f },\n",
+            encoder->window_size,
+            encoder->symbol_size,
+            redundancy,
+            symbol_num,
+            acked_num,
+            tx_packet_count,
+            repair_count,
+            acked_num > 0 ? (float)total_latency / acked_num / 1000 : 0,
+            (float)max_latency / 1000);
+    fclose(fp);
+    return 0;
+}
+
+/**
+ * @brief send a packet, fragment it if needed, return -1 on failure
+ */
+int send_packet (int fd, uint8_t* packet, uint16_t length, uint16_t* tx_frame_count)
+{
+    static virtual_packet_t tx_packet[MAX_FRAG_NUM];
+    uint8_t fragment_num = 1;
+
+    if (need_fragmentation (length) == true)
+    {
+        do_fragmentation (tx_packet, packet, length);
+        fragment_num = get_fragment_num ();
+    }
+    else
+        generate_normal_packet (&tx_packet[0], packet, length);
+    for (uint8_t j = 0; j < fragment_num; j++)
+    {
+        if (write_serial_port (fd, tx_packet[j].packet, tx_packet[j].length) < 0)
+            return -1;
+        (*tx_frame_count)++;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // cmd argument related variables
+    char* serial_port = (char*)USB_DEVICE;
+    char* log_file_name = (char*)LOG_FILE;
+    uint32_t symbol_size = 4;
+    uint32_t window_size = 8;
+    uint16_t symbol_num = 100;
+    float redundancy = 0.2;
+    uint32_t ack_timeout = 1000; // ms
+
+    // cmd arguments parsing
+    int opt;
+    int option_index = 0;
+
+    while ((opt = getopt_long (argc, argv, "p:s:w:n:r:t:l:h", long_options, &option_index)) != -1)
+    {
+        switch (opt)
+        {
+            case 'p':
+                serial_port = optarg;
+                break;
+            case 's':
+                symbol_size = atoi (optarg);
+                break;
+            case 'w':
+                window_size = atoi (optarg);
+                break;
+            case 'n':
+                symbol_num = atoi (optarg);
+                break;
+            case 'r':
+                redundancy = (float)atoi (optarg) / 100;
+                break;
+            case 't':
+                ack_timeout = atoi (optarg);
+                break;
+            case 'l':
+                log_file_name = optarg;
+                break;
+            case 'h':
+                usage ();
+                return 0;
+            default:
+                usage ();
+                return 0;
+        }
+    }
+
+    // Seed random number generator to produce different results every time
+    srand (static_cast<uint32_t> (time (0)));
+
+    // USB communication
+    int fd = open_serial_port (serial_port, B115200, 0);
+    if (fd < 0)
+    {
+        fprintf (stderr, "error %d opening %s: %s\n", errno, serial_port, strerror (errno));
+        return -1;
+    }
+
+    // encoder initialization
+    static sliding_encoder_t encoder;
+    init_sliding_encoder (&encoder, window_size, symbol_size);
+
+    // variable definitions
+    uint32_t inter_frame_interval = 30000; // inter frame interval in us
+    int ret;
+    int rx_num = 0;
+    uint8_t rx_buf[MAX_SIZE];
+    memset (rx_buf, 0, sizeof rx_buf);
+    control_frame_t control;
+    uint16_t tx_frame_count = 0;
+    uint16_t tx_packet_count = 0;
+    uint16_t repair_count = 0;
+    uint16_t next_seq = 0;
+    uint16_t acked_num = 0;
+    uint16_t seq;
+    // one repair symbol after every repair_interval source symbols
+    uint16_t repair_interval = redundancy > 0 ? (uint16_t)(1 / redundancy + 0.5) : 0;
+    uint16_t source_since_repair = 0;
+    bool repair_due = false;
+
+    // set buffers
+    uint8_t source_symbol[encoder.symbol_size];
+    uint8_t packet[IPHC_TOTAL_SIZE +
+                   UDPHC_TOTAL_SIZE +
+                   SW_REPAIR_HDR_SIZE +
+                   SW_MAX_WINDOW_SIZE +
+                   encoder.symbol_size];
+    memset (packet, 0, sizeof packet);
+    uint16_t tx_packet_length = 0;
+
+    // time related variables
+    struct timeval send_time[symbol_num];
+    struct timeval ack_time;
+    uint64_t latency = 0; // us
+    uint64_t total_latency = 0; // us
+    uint64_t max_latency = 0; // us
+    clock_t ack_timeout_start = clock();
+
+    printf ("---------sliding window configuration---------\n");
+    printf ("window size:\t\t%u\n", encoder.window_size);
+    printf ("symbol size:\t\t%u\n", encoder.symbol_size);
+    printf ("repair interval:\t%u\n", repair_interval);
+    printf ("---------sliding window configuration---------\n");
+
+    // client operations
+    while (acked_num < symbol_num)
+    {
+        if ((clock() - ack_timeout_start) * 1000 / CLOCKS_PER_SEC > ack_timeout)
+        {
+            printf ("[client] no window progress, stop streaming\n");
+            break;
+        }
+
+        // window edge feedback from server
+        rx_num = read_serial_port (fd, rx_buf, NULL, false);
+        if (rx_num > 0 &&
+            parse_control_frame (rx_buf, rx_num, &control) == true &&
+            control.type == CONTROL_WINDOW_ACK &&
+            (int16_t)(control.option - encoder.window_start) > 0 &&
+            (int16_t)(encoder.window_end - control.option) >= 0)
+        {
+            gettimeofday (&ack_time, NULL);
+            for (seq = encoder.window_start; seq != control.option; seq++)
+            {
+                latency = 1000000 * (ack_time.tv_sec - send_time[seq].tv_sec) +
+                          ack_time.tv_usec - send_time[seq].tv_usec;
+                total_latency += latency;
+                if (latency > max_latency)
+                    max_latency = latency;
+                acked_num++;
+            }
+            sliding_encoder_ack (&encoder, control.option);
+            ack_timeout_start = clock();
+            printf ("[client] window edge: %u\n", control.option);
+        }
+        memset (rx_buf, 0, sizeof rx_buf);
+
+        set_ip_header (packet);
+        set_udp_header (packet + IPHC_TOTAL_SIZE);
+        // systematic transmission of a new source symbol
+        if (is_sliding_window_full (&encoder) == false && next_seq < symbol_num)
+        {
+            // stamp source data with its sequence
+            memset (source_symbol, 'T', sizeof source_symbol);
+            if (sizeof source_symbol >= sizeof next_seq)
+                memcpy (source_symbol, &next_seq, sizeof next_seq);
+            seq = sliding_encoder_push (&encoder, source_symbol);
+            tx_packet_length = IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE +
+                               produce_sliding_systematic (&encoder,
+                                                           seq,
+                                                           packet + IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE);
+            gettimeofday (&send_time[seq], NULL);
+            ret = send_packet (fd, packet, tx_packet_length, &tx_frame_count);
+            if (ret < 0)
+                return -1;
+            printf ("[client] send systematic symbol %u\n", seq);
+            tx_packet_count++;
+            next_seq++;
+            source_since_repair++;
+            if (repair_interval > 0 && source_since_repair >= repair_interval)
+                repair_due = true;
+        }
+        // window is blocked by unacknowledged symbols
+        else if (get_sliding_window_count (&encoder) > 0)
+            repair_due = true;
+
+        // repair symbol over the current window
+        if (repair_due == true)
+        {
+            usleep (inter_frame_interval);
+            tx_packet_length = IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE +
+                               produce_sliding_repair (&encoder,
+                                                       packet + IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE);
+            ret = send_packet (fd, packet, tx_packet_length, &tx_frame_count);
+            if (ret < 0)
+                return -1;
+            printf ("[client] send repair symbol over window [%u, %u)\n",
+                    encoder.window_start,
+                    encoder.window_end);
+            tx_packet_count++;
+            repair_count++;
+            source_since_repair = 0;
+            repair_due = false;
+        }
+        usleep (inter_frame_interval);
+    } // end of while
+
+    printf ("[client] packet total send: %u\n", tx_packet_count);
+    printf ("[client] repair total send: %u\n", repair_count);
+    printf ("[client] frame total send: %u\n", tx_frame_count);
+    printf ("[client] symbol total acknowledged: %u\n", acked_num);
+    if (acked_num > 0)
+        printf ("[client] average symbol latency: %.2f ms\n", (float)total_latency / acked_num / 1000);
+
+    // write log to json file
+    ret = write_measurement_log (log_file_name,
+                                 &encoder,
+                                 redundancy,
+                                 symbol_num,
+                                 acked_num,
+                                 tx_packet_count,
+                                 repair_count,
+                                 total_latency,
+                                 max_latency);
+    if (ret < 0)
+        return -1;
+    return 0;
+}
@@ -0,0 +1,193 @@
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <stdint.h>
+#include <sys/time.h>
+#include <time.h>
+#include <stdlib.h>
+
+#include "serial.h"
+#include "utils.h"
+#include "lowpan.h"
+#include "reassemble.h"
+#include "sliding_window.h"
+#include "config.h"
+
+#define USB_DEVICE  "/dev/ttyACM0"
+#define LOG_FILE    "log.dump"
+
+static struct option long_options[] =
+{
+    {"port",        required_argument, 0, 'p'},
+    {"symbolSize",  required_argument, 0, 's'},
+    {"symbols",     required_argument, 0, 'n'},
+    {"timeout",     required_argument, 0, 't'},
+    {"logFile",     required_argument, 0, 'l'},
+    {"help",        no_argument,       0, 'h'},
+    {0, 0, 0, 0}
+};
+
+void usage(void)
+{
+    printf ("Usage: [-p --port <serial port number>] [-s --symbolSize <symbol size>] [-n --symbols <source symbols>] [-t --timeout <rx timeout in ms>] [-l --logFile <log file name>] [-h --help]\n");
+    printf ("Options:\n");
+    printf ("\t-p --port\tserial port number to open\tDefault: /dev/ttyACM0\n");
+    printf ("\t-s --symbolSize\tsymbol size\t\t\tDefault: 4\n");
+    printf ("\t-n --symbols\tsource symbols to receive\tDefault: 100\n");
+    printf ("\t-t --timeout\trx idle timeout in ms\t\tDefault: 1000\n");
+    printf ("\t-l --logFile\tlog file name\t\t\tDefault: log.dump\n");
+    printf ("\t-h --help\tthis help documetation\n");
+}
+
+int write_measurement_log (char* log_file_name,
+                           sliding_decoder_t* decoder,
+                           uint16_t symbol_num,
+                           uint16_t rx_packet_count,
+                           uint16_t innovative_count,
+                           uint16_t delivered_count,
+                           uint16_t ack_count)
+{
+    FILE* fp;
+    fp = fopen (log_file_name, "a+");
+    if (fp == NULL)
+    {
+        fprintf (stderr, "error %d opening %s: %s\n", errno, log_file_name, strerror (errno));
+        return -1;
+    }
+
+    fprintf(fp, "{\"type\": \"sliding_window_server\", \"symbol_size\": %u, \"source_num\": %u, \"rx_num\": %u, \"innovative_num\": %u, \"delivered_num\": %u, \"ack_num\": %u },\n",
+            decoder->symbol_size,
+            symbol_num,
+            rx_packet_count,
+            innovative_count,
+            delivered_count,
+            ack_count);
+    fclose(fp);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    char* serial_port = (char*)USB_DEVICE;
+    char* log_file_name = (char*)LOG_FILE;
+    uint32_t symbol_size = 4;
+    uint16_t symbol_num = 100;
+    uint32_t rx_timeout = 1000; // ms
+
+    // cmd arguments parsing
+    int opt;
+    int option_index = 0;
+
+    while ((opt = getopt_long (argc, argv, "p:s:n:t:l:h", long_options, &option_index)) != -1)
+    {
+        switch (opt)
+        {
+            case 'p':
+                serial_port = optarg;
+                break;
+            case 's':
+                symbol_size = atoi (optarg);
+                break;
+            case 'n':
+                symbol_num = atoi (optarg);
+                break;
+            case 't':
+                rx_timeout = atoi (optarg);
+                break;
+            case 'l':
+                log_file_name = optarg;
+                break;
+            case 'h':
+                usage ();
+                return 0;
+            default:
+                usage ();
+                return 0;
+        }
+    }
+
+    // USB communication
+    int fd = open_serial_port (serial_port, B115200, 0);
+    if (fd < 0)
+    {
+        fprintf (stderr, "error %d opening %s: %s\n", errno, serial_port, strerror (errno));
+        return -1;
+    }
+
+    // decoder initialization
+    static sliding_decoder_t decoder;
+    init_sliding_decoder (&decoder, symbol_size);
+
+    int ret;
+    int rx_num = 0;
+    uint16_t rx_packet_count = 0;
+    uint16_t rx_frame_count = 0;
+    uint16_t innovative_count = 0;
+    uint16_t delivered_count = 0;
+    uint16_t ack_count = 0;
+    uint16_t seq;
+    uint8_t extract_buf[MAX_PACKET_SIZE];
+    memset (extract_buf, 0, sizeof extract_buf);
+    uint8_t data_out[decoder.symbol_size];
+    uint8_t ack_packet[CONTROL_MAX_SIZE];
+    uint8_t ack_packet_length = 0;
+
+    // time related variable definition
+    clock_t rx_timeout_start = 0;
+
+    rx_timeout_start = clock();
+    // server operations
+    while (delivered_count < symbol_num)
+    {
+        if ((clock() - rx_timeout_start) * 1000 / CLOCKS_PER_SEC > rx_timeout)
+            break;
+        // receive a packet
+        rx_num = read_serial_port (fd, extract_buf, &rx_frame_count, false);
+        if (rx_num <= IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE)
+            continue;
+        rx_timeout_start = clock();
+        rx_packet_count++;
+        if (sliding_decoder_consume (&decoder,
+                                     extract_buf + IPHC_TOTAL_SIZE + UDPHC_TOTAL_SIZE,
+                                     rx_num - IPHC_TOTAL_SIZE - UDPHC_TOTAL_SIZE) == true)
+            innovative_count++;
+        // deliver decoded symbols in order as soon as possible
+        while (sliding_decoder_read (&decoder, data_out, &seq) == true)
+        {
+            printf ("[server] deliver symbol %u\n", seq);
+            print_payload (data_out, sizeof data_out);
+            delivered_count++;
+        }
+        // acknowledge the window edge
+        ack_packet_length = build_control_frame (ack_packet,
+                                                 CONTROL_WINDOW_ACK,
+                                                 (uint8_t)ack_count,
+                                                 get_sliding_window_edge (&decoder));
+        ret = write_serial_port (fd, ack_packet, ack_packet_length);
+        if (ret < 0)
+            return -1;
+        ack_count++;
+        memset (extract_buf, 0, sizeof extract_buf);
+    } // end of while
+
+    printf ("[server] window edge: %u\n", get_sliding_window_edge (&decoder));
+    printf ("[server] packet total receive: %u\n", rx_packet_count);
+    printf ("[server] innovative packet total receive: %u\n", innovative_count);
+    printf ("[server] symbol total deliver: %u\n", delivered_count);
+    printf ("[server] frame total receive: %u\n", rx_frame_count);
+
+    // write log to json file
+    ret = write_measurement_log (log_file_name,
+                                 &decoder,
+                                 symbol_num,
+                                 rx_packet_count,
+                                 innovative_count,
+                                 delivered_count,
+                                 ack_count);
+    if (ret < 0)
+        return -1;
+    return 0;
+}
@@ -44,6 +44,7 @@
 #include "fsm.h"
 #include "uart.h"
 #include "usb_cdc_acm.h"
+#include "control.h"
 #if (CONFIG_SECURE == 1)
 #include "security.h"
 #endif
@@ -508,8 +509,7 @@ static void a_radio_tx_start(void * p_data)
 
 		// radio mac configuration
         m_data_req.dst_addr_mode = MAC_ADDR_SHORT;
-        if (strcmp (&m_radio_tx_buffer[PAYLOAD_START_POSITION + 10], "relay_ack") == 0 ||
-            strcmp (&m_radio_tx_buffer[PAYLOAD_START_POSITION + 10], "server_ack") == 0)
+        if (is_control_ack (&m_radio_tx_buffer[PAYLOAD_START_POSITION], m_radio_tx_size) == true)
             m_data_req.dst_addr.short_address = CONFIG_ACK_ADDRESS;
         else
             m_data_req.dst_addr.short_address = CONFIG_OTHER_ADDRESS;
@@ -48,6 +48,7 @@
 #include "nrf_drv_clock.h"
 
 #include "fsm.h"
+#include "control.h"
 #include "uart.h"
 #include "usb_cdc_acm.h"	// XFN_CHANGE
 #include "mac_mcps_data.h"
@@ -88,8 +89,12 @@ void mcps_data_ind(mcps_data_ind_t * p_ind)
                            p_ind->src_pan_id == CONFIG_PAN_ID &&
                            p_ind->src_addr_mode == MAC_ADDR_SHORT &&
                            p_ind->src_addr.short_address != CONFIG_DEVICE_SHORT_ADDRESS;
+    // data frames are longer than 5 bytes, binary control frames only take 2 to 4
+    control_frame_t control;
+    bool length_match = p_ind->msdu_length > 5 ||
+                        parse_control_frame (p_ind->msdu.p_payload, p_ind->msdu_length, &control) == true;
 
-    if (addresses_match && (p_ind->msdu_length > 5))
+    if (addresses_match && length_match)
     {
         fsm_event_data_t data =
         {